@@ -0,0 +1,227 @@
+#include "AllocTracker.h"
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include "Profiler.h"
+
+#if ALLOC_TRACKING_ENABLED && !PROFILER_ENABLED
+#error "ALLOC_TRACKING_ENABLED counts into the profiler, it needs PROFILER_ENABLED"
+#endif
+
+#if ALLOC_TRACKING_CALL_SITES
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <dbghelp.h>
+#pragma comment(lib, "dbghelp.lib")
+#else
+#include <execinfo.h>
+#endif
+#endif
+
+Alloc_tracker global_alloc_tracker;
+
+static thread_local bool tracked_thread;
+#if ALLOC_TRACKING_ENABLED
+static thread_local bool in_tracker; // NOTE: keeps the bookkeeping from counting itself
+#endif
+
+void alloc_tracker_attach_thread() {
+	tracked_thread = true;
+}
+
+void alloc_tracker_clear_sites() {
+	Alloc_tracker &t = global_alloc_tracker;
+	memset(t.sites, 0, sizeof(t.sites));
+	t.nsites = 0;
+	t.dropped = 0;
+}
+
+#if ALLOC_TRACKING_CALL_SITES
+static void record_call_site(size_t size, int zone) {
+	Alloc_tracker &t = global_alloc_tracker;
+
+	// NOTE: skips this function, alloc_tracker_record and operator new, debug builds don't inline them
+	void *frames[ALLOC_SITE_FRAMES] = {};
+#ifdef _WIN32
+	int nframes = CaptureStackBackTrace(3, ALLOC_SITE_FRAMES, frames, NULL);
+#else
+	void *all_frames[ALLOC_SITE_FRAMES + 3];
+	int nframes = backtrace(all_frames, ALLOC_SITE_FRAMES + 3) - 3;
+	if (nframes > 0)
+		memcpy(frames, all_frames + 3, nframes * sizeof(void*));
+#endif
+	if (nframes <= 0)
+		return;
+
+	uint64_t hash = 14695981039346656037ull;
+	for (int i = 0; i < nframes; ++i)
+		hash = (hash ^ (uint64_t) frames[i]) * 1099511628211ull;
+
+	for (int i = 0; i < ALLOC_MAX_SITES; ++i) {
+		Alloc_site &site = t.sites[(hash + i) & (ALLOC_MAX_SITES - 1)];
+
+		if (site.nframes == 0) {
+			// NOTE: keeps a free slot so that lookups of unknown sites end
+			if (t.nsites == ALLOC_MAX_SITES - 1)
+				break;
+
+			memcpy(site.frames, frames, sizeof(frames));
+			site.nframes = nframes;
+			site.zone = zone;
+			t.nsites++;
+		}
+		else if (site.nframes != nframes || memcmp(site.frames, frames, sizeof(frames)) != 0) {
+			continue;
+		}
+
+		site.count++;
+		site.bytes += size;
+		return;
+	}
+
+	t.dropped++;
+}
+#endif
+
+#if ALLOC_TRACKING_CALL_SITES
+static void write_frame(FILE *f, void *frame) {
+#ifdef _WIN32
+	HANDLE process = GetCurrentProcess();
+	static bool symbols_loaded = SymInitialize(process, NULL, TRUE);
+
+	char buffer[sizeof(SYMBOL_INFO) + 256];
+	SYMBOL_INFO *symbol = (SYMBOL_INFO*) buffer;
+	symbol->SizeOfStruct = sizeof(SYMBOL_INFO);
+	symbol->MaxNameLen = 256;
+
+	DWORD64 displacement = 0;
+	if (symbols_loaded && SymFromAddr(process, (DWORD64) frame, &displacement, symbol)) {
+		IMAGEHLP_LINE64 line = {};
+		line.SizeOfStruct = sizeof(line);
+		DWORD line_displacement = 0;
+		if (SymGetLineFromAddr64(process, (DWORD64) frame, &line_displacement, &line))
+			fprintf(f, "    %s %s:%lu\n", symbol->Name, line.FileName, line.LineNumber);
+		else
+			fprintf(f, "    %s+0x%llx\n", symbol->Name, (unsigned long long) displacement);
+		return;
+	}
+#else
+	char **symbols = backtrace_symbols(&frame, 1);
+	if (symbols) {
+		fprintf(f, "    %s\n", symbols[0]);
+		free(symbols);
+		return;
+	}
+#endif
+	fprintf(f, "    %p\n", frame);
+}
+#endif
+
+// NOTE: the sites recorded since the last alloc_tracker_clear_sites, most allocations first
+void alloc_tracker_write_sites(FILE *f) {
+#if ALLOC_TRACKING_CALL_SITES
+	const Alloc_tracker &t = global_alloc_tracker;
+	const Profiler &profiler = global_profiler;
+
+	in_tracker = true;
+
+	bool written[ALLOC_MAX_SITES] = {};
+	for (;;) {
+		int best = -1;
+		for (int i = 0; i < ALLOC_MAX_SITES; ++i) {
+			if (t.sites[i].nframes != 0 && !written[i] && (best < 0 || t.sites[i].count > t.sites[best].count))
+				best = i;
+		}
+		if (best < 0)
+			break;
+		written[best] = true;
+
+		const Alloc_site &site = t.sites[best];
+		fprintf(f, "%lld allocations, %lld bytes in %s\n", (long long) site.count, (long long) site.bytes,
+			(site.zone >= 0) ? profiler.zones[site.zone].name : "no zone");
+		for (int i = 0; i < site.nframes; ++i)
+			write_frame(f, site.frames[i]);
+	}
+
+	if (t.dropped)
+		fprintf(f, "%lld allocations from call sites that didn't fit\n", (long long) t.dropped);
+
+	in_tracker = false;
+#else
+	fprintf(f, "Call sites are only recorded in debug builds with ALLOC_TRACKING_ENABLED\n");
+#endif
+}
+
+#if ALLOC_TRACKING_ENABLED
+static void alloc_tracker_record(size_t size) {
+	if (!tracked_thread || in_tracker)
+		return;
+	in_tracker = true;
+
+	Profiler &p = global_profiler;
+	p.counters[PROFILER_COUNTER_ALLOCATIONS]++;
+	p.counters[PROFILER_COUNTER_ALLOCATED_BYTES] += size;
+	if (p.current >= 0) {
+		p.zones[p.current].allocations++;
+		p.zones[p.current].allocated_bytes += size;
+	}
+
+#if ALLOC_TRACKING_CALL_SITES
+	record_call_site(size, p.current);
+#endif
+
+	in_tracker = false;
+}
+
+void *operator new(size_t size) {
+	alloc_tracker_record(size);
+	void *p = malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void *operator new[](size_t size) {
+	alloc_tracker_record(size);
+	void *p = malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+	alloc_tracker_record(size);
+	return malloc(size ? size : 1);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+	alloc_tracker_record(size);
+	return malloc(size ? size : 1);
+}
+
+void operator delete(void *p) noexcept {
+	free(p);
+}
+
+void operator delete[](void *p) noexcept {
+	free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+	free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+	free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+	free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+	free(p);
+}
+#endif
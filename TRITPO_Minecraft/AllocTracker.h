@@ -0,0 +1,43 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+
+// NOTE: set to 1 to replace the global operator new and delete with versions that count the
+// heap allocations of the main thread into the profiler, per frame and per zone
+#ifndef ALLOC_TRACKING_ENABLED
+#define ALLOC_TRACKING_ENABLED 0
+#endif
+
+// NOTE: call stacks of the allocations are only recorded in debug builds, capturing them is slow
+#if ALLOC_TRACKING_ENABLED && defined(_DEBUG)
+#define ALLOC_TRACKING_CALL_SITES 1
+#else
+#define ALLOC_TRACKING_CALL_SITES 0
+#endif
+
+#define ALLOC_SITE_FRAMES 8
+#define ALLOC_MAX_SITES 256 // NOTE: has to be a power of two
+
+// NOTE: every allocation made with the same call stack
+struct Alloc_site
+{
+	void *frames[ALLOC_SITE_FRAMES];
+	int nframes;  // NOTE: 0 for a free slot
+	int zone;     // NOTE: profiler zone open at the first allocation, -1 outside of every zone
+	int64_t count;
+	int64_t bytes;
+};
+
+struct Alloc_tracker
+{
+	Alloc_site sites[ALLOC_MAX_SITES]; // NOTE: open addressing on the hash of the frames
+	int nsites;
+	int64_t dropped; // NOTE: allocations whose call site didn't fit into sites
+};
+
+extern Alloc_tracker global_alloc_tracker;
+
+// NOTE: only allocations made on the thread that called this are counted
+void alloc_tracker_attach_thread();
+void alloc_tracker_clear_sites();
+void alloc_tracker_write_sites(FILE *f);
@@ -1,18 +1,37 @@
 #include "Chunk.h"
 #include "assert.h"
+#include "Profiler.h"
+
+void free_mesh(Mesh *m) {
+	if (m->vao != 0)
+	{
+		assert(m->vao && m->vbo);
+
+		glDeleteVertexArrays(1, &m->vao);
+		glDeleteBuffers(1, &m->vbo);
+		PROFILE_GAUGE_ADD(PROFILER_GAUGE_CHUNK_MESH_BYTES, -m->buffer_bytes);
+
+		*m = {};
+	}
+}
+
+// NOTE: has to be called with the size given to every glBufferData on the mesh vbo
+void set_mesh_buffer_bytes(Mesh *m, int bytes) {
+	PROFILE_GAUGE_ADD(PROFILER_GAUGE_CHUNK_MESH_BYTES, bytes - m->buffer_bytes);
+	m->buffer_bytes = bytes;
+}
 
 void Chunk::free_mesh() {
 	for (Mesh &m : meshes) {
-		if (m.vao != 0)
-		{
-			assert(m.vao && m.vbo);
-
-			glDeleteVertexArrays(1, &m.vao);
-			glDeleteBuffers(1, &m.vbo);
+		::free_mesh(&m);
+	}
+	::free_mesh(&shadow_mesh);
 
-			m.num_of_vs = 0;
-			m.vao = 0;
-			m.vbo = 0;
-		}
+	if (occlusion_query != 0)
+	{
+		glDeleteQueries(1, &occlusion_query);
+		occlusion_query = 0;
 	}
+	query_pending = false;
+	occluded = false;
 }
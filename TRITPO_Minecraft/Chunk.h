@@ -8,6 +8,9 @@
 #define CHUNK_DIM (1 << CHUNK_DIM_LOG2)
 #define BLOCKS_IN_CHUNK ((CHUNK_DIM) * (CHUNK_DIM) * (CHUNK_DIM))
 
+void free_mesh(Mesh *m);
+void set_mesh_buffer_bytes(Mesh *m, int bytes);
+
 class Chunk {
 	public:
 		void free_mesh();
@@ -18,6 +21,18 @@ class Chunk {
 	    int nblocks;
 		bool changed;
 		bool render;
+		bool occluded;      // NOTE: last finished occlusion query saw none of the chunk
+		bool query_pending;
+		bool unreachable;   // NOTE: can't be seen from the camera chunk through connected faces
+		uint64_t connectivity;
+		bool below_horizon;
+		int surface_min;    // NOTE: lowest and highest generated terrain height in the chunk's column,
+		int surface_max;    // only valid while the chunk isn't changed
+		float view_dist;    // NOTE: squared distance to the camera, for draw ordering
+		GLuint occlusion_query;
+		int edit_cache;
+		int lod;
 		uint8_t blocks[CHUNK_DIM * CHUNK_DIM * CHUNK_DIM];
 		Mesh meshes[BLOCK_TYPE_COUNT];
+		Mesh shadow_mesh;   // NOTE: position only, all block types merged
 };
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "FarTerrain.h"
+#include <math.h>
+#include "Terrain.h"
+
+static int floorDiv(int a, int b) {
+	return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+static int wrap(int i) {
+	int r = i % FAR_TERRAIN_SAMPLES;
+	return (r < 0) ? r + FAR_TERRAIN_SAMPLES : r;
+}
+
+// NOTE: position and normal for every vertex of the biggest level mesh
+static float vertices[FAR_TERRAIN_GRID * FAR_TERRAIN_GRID * 6 * 6];
+
+FarTerrain::FarTerrain() : m_holeRadius(0) {
+	for (int i = 0; i < FAR_TERRAIN_LEVELS; ++i) {
+		Level &level = m_levels[i];
+		level.spacing = FAR_TERRAIN_SPACING << i;
+		level.originX = 0;
+		level.originZ = 0;
+		level.valid = false;
+		level.numOfVs = 0;
+
+		glGenVertexArrays(1, &level.vao);
+		glGenBuffers(1, &level.vbo);
+
+		glBindVertexArray(level.vao);
+		glBindBuffer(GL_ARRAY_BUFFER, level.vbo);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), NULL, GL_DYNAMIC_DRAW);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 6, (void *)0);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 6, (void *)(sizeof(float) * 3));
+		glEnableVertexAttribArray(1);
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+}
+
+FarTerrain::~FarTerrain() {
+	for (Level &level : m_levels) {
+		glDeleteVertexArrays(1, &level.vao);
+		glDeleteBuffers(1, &level.vbo);
+	}
+}
+
+void FarTerrain::update(float camX, float camZ, int holeRadius) {
+	bool holeChanged = holeRadius != m_holeRadius;
+	m_holeRadius = holeRadius;
+
+	bool innerMoved = false;
+
+	for (int i = 0; i < FAR_TERRAIN_LEVELS; ++i) {
+		Level &level = m_levels[i];
+
+		// NOTE: the window is snapped to every second sample, so its border lies on the samples of the next level
+		int centerX = floorDiv((int) floorf(camX), level.spacing * 2) * 2;
+		int centerZ = floorDiv((int) floorf(camZ), level.spacing * 2) * 2;
+		int originX = centerX - FAR_TERRAIN_GRID / 2;
+		int originZ = centerZ - FAR_TERRAIN_GRID / 2;
+
+		bool moved = !level.valid || originX != level.originX || originZ != level.originZ;
+
+		if (moved) {
+			for (int sz = originZ; sz <= originZ + FAR_TERRAIN_GRID; ++sz) {
+				for (int sx = originX; sx <= originX + FAR_TERRAIN_GRID; ++sx) {
+					bool cached = level.valid &&
+						sx >= level.originX && sx <= level.originX + FAR_TERRAIN_GRID &&
+						sz >= level.originZ && sz <= level.originZ + FAR_TERRAIN_GRID;
+
+					if (!cached)
+						level.heights[wrap(sz) * FAR_TERRAIN_SAMPLES + wrap(sx)] = (float) get_height(sx * level.spacing, sz * level.spacing);
+				}
+			}
+
+			level.originX = originX;
+			level.originZ = originZ;
+			level.valid = true;
+		}
+
+		// NOTE: a level also changes when the hole it surrounds has moved
+		if (moved || innerMoved || (i == 0 && holeChanged))
+			rebuildMesh(i, holeRadius);
+
+		innerMoved = moved;
+	}
+}
+
+float FarTerrain::height(const Level &level, int sx, int sz) {
+	return level.heights[wrap(sz) * FAR_TERRAIN_SAMPLES + wrap(sx)];
+}
+
+void FarTerrain::rebuildMesh(int levelIdx, int holeRadius) {
+	Level &level = m_levels[levelIdx];
+
+	// NOTE: hole in samples of this level, either the previous level or the area around the camera
+	int holeMinX, holeMinZ, holeMaxX, holeMaxZ;
+	if (levelIdx > 0) {
+		const Level &inner = m_levels[levelIdx - 1];
+		holeMinX = inner.originX / 2;
+		holeMinZ = inner.originZ / 2;
+		holeMaxX = holeMinX + FAR_TERRAIN_GRID / 2;
+		holeMaxZ = holeMinZ + FAR_TERRAIN_GRID / 2;
+	}
+	else {
+		int centerX = level.originX + FAR_TERRAIN_GRID / 2;
+		int centerZ = level.originZ + FAR_TERRAIN_GRID / 2;
+		int holeSamples = holeRadius / level.spacing;
+		holeMinX = centerX - holeSamples;
+		holeMinZ = centerZ - holeSamples;
+		holeMaxX = centerX + holeSamples;
+		holeMaxZ = centerZ + holeSamples;
+	}
+
+	float heights[FAR_TERRAIN_SAMPLES][FAR_TERRAIN_SAMPLES];
+	for (int z = 0; z <= FAR_TERRAIN_GRID; ++z) {
+		for (int x = 0; x <= FAR_TERRAIN_GRID; ++x) {
+			heights[z][x] = height(level, level.originX + x, level.originZ + z);
+		}
+	}
+
+	// NOTE: odd samples on the outer border are pulled onto the edge of the next level, so there are no cracks between levels
+	if (levelIdx < FAR_TERRAIN_LEVELS - 1) {
+		for (int i = 1; i < FAR_TERRAIN_GRID; i += 2) {
+			heights[0][i] = (heights[0][i - 1] + heights[0][i + 1]) / 2;
+			heights[FAR_TERRAIN_GRID][i] = (heights[FAR_TERRAIN_GRID][i - 1] + heights[FAR_TERRAIN_GRID][i + 1]) / 2;
+			heights[i][0] = (heights[i - 1][0] + heights[i + 1][0]) / 2;
+			heights[i][FAR_TERRAIN_GRID] = (heights[i - 1][FAR_TERRAIN_GRID] + heights[i + 1][FAR_TERRAIN_GRID]) / 2;
+		}
+	}
+
+	int v = 0;
+	for (int z = 0; z < FAR_TERRAIN_GRID; ++z) {
+		for (int x = 0; x < FAR_TERRAIN_GRID; ++x) {
+			int sx = level.originX + x;
+			int sz = level.originZ + z;
+
+			if (sx >= holeMinX && sx < holeMaxX && sz >= holeMinZ && sz < holeMaxZ)
+				continue;
+
+			// NOTE: p00, p01, p10 and p10, p01, p11 are counter clockwise seen from above
+			int corners[6][2] = { { 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 0 }, { 0, 1 }, { 1, 1 } };
+			for (int c = 0; c < 6; ++c) {
+				int cx = x + corners[c][0];
+				int cz = z + corners[c][1];
+
+				float dx = heights[cz][cx < FAR_TERRAIN_GRID ? cx + 1 : cx] - heights[cz][cx > 0 ? cx - 1 : cx];
+				float dz = heights[cz < FAR_TERRAIN_GRID ? cz + 1 : cz][cx] - heights[cz > 0 ? cz - 1 : cz][cx];
+				float nx = -dx, ny = 2.0f * level.spacing, nz = -dz;
+				float len = sqrtf(nx * nx + ny * ny + nz * nz);
+
+				float *out = &vertices[v * 6];
+				out[0] = (float) ((level.originX + cx) * level.spacing);
+				out[1] = heights[cz][cx];
+				out[2] = (float) ((level.originZ + cz) * level.spacing);
+				out[3] = nx / len;
+				out[4] = ny / len;
+				out[5] = nz / len;
+				v++;
+			}
+		}
+	}
+
+	level.numOfVs = v;
+
+	glBindBuffer(GL_ARRAY_BUFFER, level.vbo);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, v * sizeof(float) * 6, vertices);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void FarTerrain::render() {
+	for (Level &level : m_levels) {
+		if (level.numOfVs) {
+			glBindVertexArray(level.vao);
+			glDrawArrays(GL_TRIANGLES, 0, level.numOfVs);
+		}
+	}
+
+	glBindVertexArray(0);
+}
+
+float FarTerrain::extent() {
+	return (float) (FAR_TERRAIN_GRID / 2 * m_levels[FAR_TERRAIN_LEVELS - 1].spacing);
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "glad\glad.h"
+
+#define FAR_TERRAIN_LEVELS 5
+#define FAR_TERRAIN_GRID 64   // NOTE: cells per side of a level, has to be a multiple of 4
+#define FAR_TERRAIN_SPACING 8 // NOTE: blocks between the samples of the finest level
+#define FAR_TERRAIN_SAMPLES (FAR_TERRAIN_GRID + 1)
+
+// NOTE: clipmap of heightmap rings around the camera, level n has samples every
+// FAR_TERRAIN_SPACING << n blocks and covers the hole left by level n - 1.
+// Heights come from get_height only, so there is no block data behind it.
+class FarTerrain {
+	public:
+		FarTerrain();
+		~FarTerrain();
+
+		// NOTE: moves the levels with the camera, only samples that entered a level are generated.
+		// Cells of the finest level closer than holeRadius blocks to the camera are left out.
+		void update(float camX, float camZ, int holeRadius);
+		void render();
+
+		float extent();
+
+	private:
+		struct Level {
+			int spacing;
+			int originX, originZ; // NOTE: first sample of the window, in samples
+			bool valid;
+			float heights[FAR_TERRAIN_SAMPLES * FAR_TERRAIN_SAMPLES]; // NOTE: toroidal, indexed by sample mod FAR_TERRAIN_SAMPLES
+
+			GLuint vao, vbo;
+			int numOfVs;
+		};
+
+		float height(const Level &level, int sx, int sz);
+		void rebuildMesh(int levelIdx, int holeRadius);
+
+		Level m_levels[FAR_TERRAIN_LEVELS];
+		int m_holeRadius;
+};
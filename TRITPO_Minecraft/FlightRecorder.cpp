@@ -0,0 +1,70 @@
+#include "FlightRecorder.h"
+#include <stdio.h>
+
+Flight_recorder global_flight_recorder = { {}, 0, FLIGHT_RECORDER_THRESHOLD_MS, 0, 0 };
+
+void flight_recorder_end_frame(const Profiler &profiler) {
+	Flight_recorder &r = global_flight_recorder;
+
+	Flight_frame &f = r.frames[r.nframes % FLIGHT_RECORDER_FRAMES];
+	f.frame = profiler.frame;
+	f.frame_ms = profiler.last_frame_ms;
+	for (int i = 0; i < PROFILER_MAX_ZONES; ++i)
+		f.zone_ms[i] = (i < profiler.nzones) ? profiler.zones[i].frame_ms : 0.0;
+	for (int i = 0; i < PROFILER_COUNTER_COUNT; ++i)
+		f.counters[i] = profiler.counters[i];
+
+	r.nframes++;
+	r.frames_since_dump++;
+
+	if (f.frame_ms > r.threshold_ms && r.frames_since_dump >= FLIGHT_RECORDER_FRAMES) {
+		if (flight_recorder_dump())
+			r.frames_since_dump = 0;
+	}
+}
+
+static void write_zone_path(FILE *f, const Profiler &profiler, int zone) {
+	if (profiler.zones[zone].parent >= 0) {
+		write_zone_path(f, profiler, profiler.zones[zone].parent);
+		fputc('/', f);
+	}
+	fputs(profiler.zones[zone].name, f);
+}
+
+bool flight_recorder_dump() {
+	Flight_recorder &r = global_flight_recorder;
+	const Profiler &profiler = global_profiler;
+
+	char path[64];
+	snprintf(path, sizeof(path), "slow_frame_%d.csv", r.ndumps);
+	FILE *f = fopen(path, "w");
+	if (!f)
+		return false;
+	r.ndumps++;
+
+	fprintf(f, "frame,frame_ms");
+	for (int i = 0; i < PROFILER_COUNTER_COUNT; ++i)
+		fprintf(f, ",%s", profiler_counter_names[i]);
+	for (int i = 0; i < profiler.nzones; ++i) {
+		fputc(',', f);
+		write_zone_path(f, profiler, i);
+	}
+	fputc('\n', f);
+
+	// NOTE: oldest frame first, the slow one is the last line
+	int nframes = (r.nframes < FLIGHT_RECORDER_FRAMES) ? r.nframes : FLIGHT_RECORDER_FRAMES;
+	for (int i = r.nframes - nframes; i < r.nframes; ++i) {
+		const Flight_frame &frame = r.frames[i % FLIGHT_RECORDER_FRAMES];
+
+		fprintf(f, "%d,%.3f", frame.frame, frame.frame_ms);
+		for (int j = 0; j < PROFILER_COUNTER_COUNT; ++j)
+			fprintf(f, ",%lld", (long long) frame.counters[j]);
+		for (int j = 0; j < profiler.nzones; ++j)
+			fprintf(f, ",%.3f", frame.zone_ms[j]);
+		fputc('\n', f);
+	}
+
+	fclose(f);
+	printf("Slow frame (%.1f ms), last %d frames written to %s\n", r.frames[(r.nframes - 1) % FLIGHT_RECORDER_FRAMES].frame_ms, nframes, path);
+	return true;
+}
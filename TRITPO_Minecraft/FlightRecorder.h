@@ -0,0 +1,32 @@
+#pragma once
+#include <stdint.h>
+#include "Profiler.h"
+
+#define FLIGHT_RECORDER_FRAMES 120
+#define FLIGHT_RECORDER_THRESHOLD_MS 50.0 // NOTE: default, --slow-frame-ms overrides it
+
+// NOTE: zone times and counters of one finished frame, zones are indexed like Profiler::zones
+struct Flight_frame
+{
+	int frame;
+	double frame_ms;
+	double zone_ms[PROFILER_MAX_ZONES];
+	int64_t counters[PROFILER_COUNTER_COUNT];
+};
+
+// NOTE: keeps the last FLIGHT_RECORDER_FRAMES frames, a frame slower than the threshold
+// dumps all of them to slow_frame_<n>.csv. The window has to fill up before every dump, which also
+// keeps the loading frames at startup out.
+struct Flight_recorder
+{
+	Flight_frame frames[FLIGHT_RECORDER_FRAMES];
+	int nframes;
+	double threshold_ms;
+	int frames_since_dump;
+	int ndumps;
+};
+
+extern Flight_recorder global_flight_recorder;
+
+void flight_recorder_end_frame(const Profiler &profiler);
+bool flight_recorder_dump();
@@ -0,0 +1,185 @@
+#include "GlCounters.h"
+#include "glad\glad.h"
+#include "Profiler.h"
+
+static PFNGLDRAWARRAYSPROC real_glDrawArrays;
+static PFNGLMULTIDRAWARRAYSPROC real_glMultiDrawArrays;
+static PFNGLBUFFERDATAPROC real_glBufferData;
+static PFNGLBUFFERSUBDATAPROC real_glBufferSubData;
+static PFNGLTEXIMAGE2DPROC real_glTexImage2D;
+static PFNGLTEXSUBIMAGE2DPROC real_glTexSubImage2D;
+static PFNGLBINDVERTEXARRAYPROC real_glBindVertexArray;
+static PFNGLUSEPROGRAMPROC real_glUseProgram;
+static PFNGLBINDTEXTUREPROC real_glBindTexture;
+static PFNGLUNIFORM1IPROC real_glUniform1i;
+static PFNGLUNIFORM1FPROC real_glUniform1f;
+static PFNGLUNIFORM2FPROC real_glUniform2f;
+static PFNGLUNIFORM3FPROC real_glUniform3f;
+static PFNGLUNIFORM3FVPROC real_glUniform3fv;
+static PFNGLUNIFORMMATRIX4FVPROC real_glUniformMatrix4fv;
+static PFNGLGENVERTEXARRAYSPROC real_glGenVertexArrays;
+static PFNGLDELETEVERTEXARRAYSPROC real_glDeleteVertexArrays;
+static PFNGLGENBUFFERSPROC real_glGenBuffers;
+static PFNGLDELETEBUFFERSPROC real_glDeleteBuffers;
+
+static int64_t pixel_bytes(GLenum format, GLenum type) {
+	int channels = 4;
+	switch (format) {
+		case GL_RED: case GL_DEPTH_COMPONENT: channels = 1; break;
+		case GL_RG: channels = 2; break;
+		case GL_RGB: case GL_BGR: channels = 3; break;
+	}
+
+	int size = 1;
+	switch (type) {
+		case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT: size = 2; break;
+		case GL_UNSIGNED_INT: case GL_INT: case GL_FLOAT: size = 4; break;
+	}
+
+	return channels * size;
+}
+
+static void count_upload(int64_t bytes) {
+	profiler_count(PROFILER_COUNTER_UPLOADS, 1);
+	profiler_count(PROFILER_COUNTER_BYTES_UPLOADED, bytes);
+}
+
+static void APIENTRY counted_glDrawArrays(GLenum mode, GLint first, GLsizei count) {
+	profiler_count(PROFILER_COUNTER_DRAW_CALLS, 1);
+	profiler_count(PROFILER_COUNTER_VERTICES, count);
+	real_glDrawArrays(mode, first, count);
+}
+
+static void APIENTRY counted_glMultiDrawArrays(GLenum mode, const GLint *first, const GLsizei *count, GLsizei drawcount) {
+	int64_t vertices = 0;
+	for (int i = 0; i < drawcount; ++i)
+		vertices += count[i];
+
+	profiler_count(PROFILER_COUNTER_DRAW_CALLS, 1);
+	profiler_count(PROFILER_COUNTER_VERTICES, vertices);
+	real_glMultiDrawArrays(mode, first, count, drawcount);
+}
+
+// NOTE: a NULL data pointer only allocates or orphans, nothing is uploaded
+static void APIENTRY counted_glBufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage) {
+	if (data)
+		count_upload(size);
+	real_glBufferData(target, size, data, usage);
+}
+
+static void APIENTRY counted_glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data) {
+	count_upload(size);
+	real_glBufferSubData(target, offset, size, data);
+}
+
+static void APIENTRY counted_glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels) {
+	if (pixels)
+		count_upload((int64_t) width * height * pixel_bytes(format, type));
+	real_glTexImage2D(target, level, internalformat, width, height, border, format, type, pixels);
+}
+
+static void APIENTRY counted_glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels) {
+	count_upload((int64_t) width * height * pixel_bytes(format, type));
+	real_glTexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, pixels);
+}
+
+static void APIENTRY counted_glBindVertexArray(GLuint array) {
+	profiler_count(PROFILER_COUNTER_VAO_BINDS, 1);
+	real_glBindVertexArray(array);
+}
+
+static void APIENTRY counted_glUseProgram(GLuint program) {
+	profiler_count(PROFILER_COUNTER_PROGRAM_BINDS, 1);
+	real_glUseProgram(program);
+}
+
+static void APIENTRY counted_glBindTexture(GLenum target, GLuint texture) {
+	profiler_count(PROFILER_COUNTER_TEXTURE_BINDS, 1);
+	real_glBindTexture(target, texture);
+}
+
+static void APIENTRY counted_glUniform1i(GLint location, GLint v0) {
+	profiler_count(PROFILER_COUNTER_UNIFORMS, 1);
+	real_glUniform1i(location, v0);
+}
+
+static void APIENTRY counted_glUniform1f(GLint location, GLfloat v0) {
+	profiler_count(PROFILER_COUNTER_UNIFORMS, 1);
+	real_glUniform1f(location, v0);
+}
+
+static void APIENTRY counted_glUniform2f(GLint location, GLfloat v0, GLfloat v1) {
+	profiler_count(PROFILER_COUNTER_UNIFORMS, 1);
+	real_glUniform2f(location, v0, v1);
+}
+
+static void APIENTRY counted_glUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2) {
+	profiler_count(PROFILER_COUNTER_UNIFORMS, 1);
+	real_glUniform3f(location, v0, v1, v2);
+}
+
+static void APIENTRY counted_glUniform3fv(GLint location, GLsizei count, const GLfloat *value) {
+	profiler_count(PROFILER_COUNTER_UNIFORMS, 1);
+	real_glUniform3fv(location, count, value);
+}
+
+static void APIENTRY counted_glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value) {
+	profiler_count(PROFILER_COUNTER_UNIFORMS, 1);
+	real_glUniformMatrix4fv(location, count, transpose, value);
+}
+
+// NOTE: names given to glDelete* are only counted if nonzero, the same as GL ignores zeros
+static int64_t nonzero_names(GLsizei n, const GLuint *names) {
+	int64_t count = 0;
+	for (int i = 0; i < n; ++i)
+		if (names[i])
+			++count;
+	return count;
+}
+
+static void APIENTRY counted_glGenVertexArrays(GLsizei n, GLuint *arrays) {
+	profiler_gauge_add(PROFILER_GAUGE_LIVE_VAOS, n);
+	real_glGenVertexArrays(n, arrays);
+}
+
+static void APIENTRY counted_glDeleteVertexArrays(GLsizei n, const GLuint *arrays) {
+	profiler_gauge_add(PROFILER_GAUGE_LIVE_VAOS, -nonzero_names(n, arrays));
+	real_glDeleteVertexArrays(n, arrays);
+}
+
+static void APIENTRY counted_glGenBuffers(GLsizei n, GLuint *buffers) {
+	profiler_gauge_add(PROFILER_GAUGE_LIVE_BUFFERS, n);
+	real_glGenBuffers(n, buffers);
+}
+
+static void APIENTRY counted_glDeleteBuffers(GLsizei n, const GLuint *buffers) {
+	profiler_gauge_add(PROFILER_GAUGE_LIVE_BUFFERS, -nonzero_names(n, buffers));
+	real_glDeleteBuffers(n, buffers);
+}
+
+#define GL_COUNTERS_HOOK(name) \
+	do { real_##name = glad_##name; glad_##name = counted_##name; } while (0)
+
+void gl_counters_install() {
+#if PROFILER_ENABLED
+	GL_COUNTERS_HOOK(glDrawArrays);
+	GL_COUNTERS_HOOK(glMultiDrawArrays);
+	GL_COUNTERS_HOOK(glBufferData);
+	GL_COUNTERS_HOOK(glBufferSubData);
+	GL_COUNTERS_HOOK(glTexImage2D);
+	GL_COUNTERS_HOOK(glTexSubImage2D);
+	GL_COUNTERS_HOOK(glBindVertexArray);
+	GL_COUNTERS_HOOK(glUseProgram);
+	GL_COUNTERS_HOOK(glBindTexture);
+	GL_COUNTERS_HOOK(glUniform1i);
+	GL_COUNTERS_HOOK(glUniform1f);
+	GL_COUNTERS_HOOK(glUniform2f);
+	GL_COUNTERS_HOOK(glUniform3f);
+	GL_COUNTERS_HOOK(glUniform3fv);
+	GL_COUNTERS_HOOK(glUniformMatrix4fv);
+	GL_COUNTERS_HOOK(glGenVertexArrays);
+	GL_COUNTERS_HOOK(glDeleteVertexArrays);
+	GL_COUNTERS_HOOK(glGenBuffers);
+	GL_COUNTERS_HOOK(glDeleteBuffers);
+#endif
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+// NOTE: swaps the loaded glad function pointers for wrappers that feed the profiler counters and gauges,
+// has to run after gladLoadGLLoader
+void gl_counters_install();
@@ -0,0 +1,107 @@
+#include "GpuProfiler.h"
+
+Gpu_profiler global_gpu_profiler = { {}, 0, -1, 0, nullptr };
+
+int gpu_profiler_begin(const char *name) {
+	Gpu_profiler &p = global_gpu_profiler;
+	if (p.active >= 0)
+		return -1;
+
+	int pass = -1;
+	for (int i = 0; i < p.npasses; ++i) {
+		if (p.passes[i].name == name) {
+			pass = i;
+			break;
+		}
+	}
+
+	if (pass < 0) {
+		if (p.npasses == GPU_PROFILER_MAX_PASSES)
+			return -1;
+
+		pass = p.npasses++;
+		Gpu_pass &g = p.passes[pass];
+		g = {};
+		g.name = name;
+		glGenQueries(GPU_PROFILER_FRAMES, g.queries);
+	}
+
+	// NOTE: a result that still was not available is dropped, reusing the query never waits for it
+	int slot = p.frame % GPU_PROFILER_FRAMES;
+	glBeginQuery(GL_TIME_ELAPSED, p.passes[pass].queries[slot]);
+	p.passes[pass].pending[slot] = true;
+	p.active = pass;
+
+	return pass;
+}
+
+void gpu_profiler_end(int pass) {
+	Gpu_profiler &p = global_gpu_profiler;
+	if (pass < 0 || pass != p.active)
+		return;
+
+	glEndQuery(GL_TIME_ELAPSED);
+	p.active = -1;
+}
+
+void gpu_profiler_end_frame() {
+	Gpu_profiler &p = global_gpu_profiler;
+
+	// NOTE: the oldest frame in flight is read, it is reused by the next frame
+	int slot = (p.frame + 1) % GPU_PROFILER_FRAMES;
+	int issued = p.frame - (GPU_PROFILER_FRAMES - 1);
+
+	for (int i = 0; i < p.npasses; ++i) {
+		Gpu_pass &g = p.passes[i];
+		if (!g.pending[slot])
+			continue;
+
+		GLint available = 0;
+		glGetQueryObjectiv(g.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			continue;
+
+		GLuint64 ns = 0;
+		glGetQueryObjectui64v(g.queries[slot], GL_QUERY_RESULT, &ns);
+		g.pending[slot] = false;
+
+		g.last_ms = ns / 1000000.0;
+		g.history[g.nsamples % PROFILER_HISTORY] = g.last_ms;
+		g.nsamples++;
+
+		int samples = (g.nsamples < PROFILER_HISTORY) ? g.nsamples : PROFILER_HISTORY;
+		double sum = 0.0;
+		g.max_ms = 0.0;
+		for (int j = 0; j < samples; ++j) {
+			sum += g.history[j];
+			if (g.history[j] > g.max_ms)
+				g.max_ms = g.history[j];
+		}
+		g.avg_ms = sum / samples;
+
+		if (p.csv)
+			fprintf(p.csv, "%d,%s,%.4f\n", issued, g.name, g.last_ms);
+	}
+
+	p.frame++;
+}
+
+bool gpu_profiler_open_csv(const char *path) {
+	Gpu_profiler &p = global_gpu_profiler;
+	gpu_profiler_close_csv();
+
+	p.csv = fopen(path, "w");
+	if (!p.csv)
+		return false;
+
+	fprintf(p.csv, "frame,pass,ms\n");
+	return true;
+}
+
+void gpu_profiler_close_csv() {
+	Gpu_profiler &p = global_gpu_profiler;
+	if (p.csv) {
+		fclose(p.csv);
+		p.csv = nullptr;
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <stdio.h>
+#include "glad\glad.h"
+#include "Profiler.h"
+
+#define GPU_PROFILER_FRAMES 3 // NOTE: frames in flight, a query is read back this many frames after it was issued
+#define GPU_PROFILER_MAX_PASSES 16
+
+// NOTE: GL_TIME_ELAPSED queries of one render pass, one per frame in flight
+struct Gpu_pass
+{
+	const char *name; // NOTE: compared by pointer, has to be a string literal
+	GLuint queries[GPU_PROFILER_FRAMES];
+	bool pending[GPU_PROFILER_FRAMES];
+
+	double history[PROFILER_HISTORY];
+	int nsamples;
+	double last_ms;
+	double avg_ms;
+	double max_ms;
+};
+
+struct Gpu_profiler
+{
+	Gpu_pass passes[GPU_PROFILER_MAX_PASSES];
+	int npasses;
+	int active; // NOTE: timer queries do not nest, so only one pass is timed at a time
+	int frame;
+
+	FILE *csv;
+};
+
+extern Gpu_profiler global_gpu_profiler;
+
+int gpu_profiler_begin(const char *name);
+void gpu_profiler_end(int pass);
+void gpu_profiler_end_frame();
+
+// NOTE: writes frame, pass and milliseconds for every result read back, as long as the log is open
+bool gpu_profiler_open_csv(const char *path);
+void gpu_profiler_close_csv();
+
+class Gpu_profile_scope {
+	public:
+		explicit Gpu_profile_scope(const char *name) : m_pass(gpu_profiler_begin(name)) {}
+		~Gpu_profile_scope() { gpu_profiler_end(m_pass); }
+
+	private:
+		int m_pass;
+};
+
+#if PROFILER_ENABLED
+#define GPU_PROFILE_SCOPE(name) Gpu_profile_scope PROFILE_CONCAT(gpu_profile_scope_, __LINE__)(name)
+#define GPU_PROFILE_END_FRAME() gpu_profiler_end_frame()
+#else
+#define GPU_PROFILE_SCOPE(name)
+#define GPU_PROFILE_END_FRAME()
+#endif
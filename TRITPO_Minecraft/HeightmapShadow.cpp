@@ -0,0 +1,183 @@
+#include "HeightmapShadow.h"
+#include <math.h>
+#include <algorithm>
+#include "Terrain.h"
+#include "World.h"
+
+static int floorDiv(int a, int b) {
+	return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+HeightmapShadow::HeightmapShadow() : m_maxHeight(0.0f), m_originX(0), m_originZ(0), m_valid(false), m_nextRow(0),
+	m_dirX(1.0f), m_dirZ(0.0f), m_slope(1.0f) {
+	for (int i = 0; i < HEIGHTMAP_SHADOW_SIZE * HEIGHTMAP_SHADOW_SIZE; ++i) {
+		m_heights[i] = 0.0f;
+		m_occluded[i] = -INFINITY;
+	}
+
+	for (int i = 0; i < HEIGHTMAP_SHADOW_SIZE; ++i)
+		m_rowDirty[i] = false;
+
+	glGenTextures(1, &m_texture);
+	glBindTexture(GL_TEXTURE_2D, m_texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, HEIGHTMAP_SHADOW_SIZE, HEIGHTMAP_SHADOW_SIZE, 0, GL_RED, GL_FLOAT, m_occluded);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+HeightmapShadow::~HeightmapShadow() {
+	glDeleteTextures(1, &m_texture);
+}
+
+int HeightmapShadow::index(int x, int z) {
+	int tx = x & (HEIGHTMAP_SHADOW_SIZE - 1);
+	int tz = z & (HEIGHTMAP_SHADOW_SIZE - 1);
+
+	return tz * HEIGHTMAP_SHADOW_SIZE + tx;
+}
+
+bool HeightmapShadow::inside(int x, int z) {
+	return x >= m_originX && x < m_originX + HEIGHTMAP_SHADOW_SIZE && z >= m_originZ && z < m_originZ + HEIGHTMAP_SHADOW_SIZE;
+}
+
+void HeightmapShadow::updateColumn(int x, int z) {
+	float occluded = -INFINITY;
+
+	for (int k = 1; k <= HEIGHTMAP_SHADOW_MARCH; ++k) {
+		float drop = k * m_slope;
+		if (m_maxHeight - drop <= occluded)
+			break;
+
+		int sx = x + (int) floorf(k * m_dirX + 0.5f);
+		int sz = z + (int) floorf(k * m_dirZ + 0.5f);
+		if (!inside(sx, sz))
+			break;
+
+		occluded = std::max(occluded, m_heights[index(sx, sz)] - drop);
+	}
+
+	m_occluded[index(x, z)] = occluded;
+	m_rowDirty[z & (HEIGHTMAP_SHADOW_SIZE - 1)] = true;
+}
+
+void HeightmapShadow::update(float camX, float camZ, glm::vec3 lightDir) {
+	// NOTE: a sun at the horizon would need an endless walk, very steep suns cast no terrain shadows
+	float horizontal = sqrtf(lightDir.x * lightDir.x + lightDir.z * lightDir.z);
+	if (horizontal > 0.0001f && lightDir.y > 0.0f) {
+		m_dirX = lightDir.x / horizontal;
+		m_dirZ = lightDir.z / horizontal;
+		m_slope = std::max(lightDir.y / horizontal, 0.05f);
+	}
+	else {
+		m_slope = INFINITY;
+	}
+
+	int originX = floorDiv((int) floorf(camX), 16) * 16 - HEIGHTMAP_SHADOW_SIZE / 2;
+	int originZ = floorDiv((int) floorf(camZ), 16) * 16 - HEIGHTMAP_SHADOW_SIZE / 2;
+
+	if (!m_valid || originX != m_originX || originZ != m_originZ) {
+		int oldOriginX = m_originX;
+		int oldOriginZ = m_originZ;
+		bool wasValid = m_valid;
+
+		m_originX = originX;
+		m_originZ = originZ;
+		m_valid = true;
+
+		for (int z = originZ; z < originZ + HEIGHTMAP_SHADOW_SIZE; ++z) {
+			for (int x = originX; x < originX + HEIGHTMAP_SHADOW_SIZE; ++x) {
+				bool cached = wasValid &&
+					x >= oldOriginX && x < oldOriginX + HEIGHTMAP_SHADOW_SIZE &&
+					z >= oldOriginZ && z < oldOriginZ + HEIGHTMAP_SHADOW_SIZE;
+
+				if (!cached) {
+					float h = (float) get_height(x, z);
+					m_heights[index(x, z)] = h;
+					m_maxHeight = std::max(m_maxHeight, h);
+				}
+			}
+		}
+
+		// NOTE: new columns get their shadow right away, the others catch up with the row refresh
+		for (int z = originZ; z < originZ + HEIGHTMAP_SHADOW_SIZE; ++z) {
+			for (int x = originX; x < originX + HEIGHTMAP_SHADOW_SIZE; ++x) {
+				bool cached = wasValid &&
+					x >= oldOriginX && x < oldOriginX + HEIGHTMAP_SHADOW_SIZE &&
+					z >= oldOriginZ && z < oldOriginZ + HEIGHTMAP_SHADOW_SIZE;
+
+				if (!cached)
+					updateColumn(x, z);
+			}
+		}
+	}
+
+	// NOTE: the sun moves slowly, so a few rows per frame keep up with it
+	for (int i = 0; i < HEIGHTMAP_SHADOW_ROWS_PER_FRAME; ++i) {
+		int z = m_originZ + m_nextRow;
+		for (int x = m_originX; x < m_originX + HEIGHTMAP_SHADOW_SIZE; ++x)
+			updateColumn(x, z);
+
+		m_nextRow = (m_nextRow + 1) % HEIGHTMAP_SHADOW_SIZE;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, m_texture);
+	for (int row = 0; row < HEIGHTMAP_SHADOW_SIZE; ++row) {
+		if (m_rowDirty[row]) {
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, row, HEIGHTMAP_SHADOW_SIZE, 1, GL_RED, GL_FLOAT, &m_occluded[row * HEIGHTMAP_SHADOW_SIZE]);
+			m_rowDirty[row] = false;
+		}
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void HeightmapShadow::blockChanged(World &world, int x, int y, int z) {
+	if (!m_valid || !inside(x, z))
+		return;
+
+	float &height = m_heights[index(x, z)];
+
+	// NOTE: the column height is the top of its highest solid block, removing that block scans down for the next one
+	if ((float) y + 1 > height) {
+		height = (float) y + 1;
+		m_maxHeight = std::max(m_maxHeight, height);
+	}
+	else if ((float) y + 1 == height) {
+		int top = y;
+		for (; top >= y - HEIGHTMAP_SHADOW_MARCH; --top) {
+			Chunk *c = world.find_chunk(x >> CHUNK_DIM_LOG2, top >> CHUNK_DIM_LOG2, z >> CHUNK_DIM_LOG2);
+			if (!c)
+				break;
+
+			int mask = CHUNK_DIM - 1;
+			if (c->blocks[CHUNK_DIM * CHUNK_DIM * (top & mask) + CHUNK_DIM * (z & mask) + (x & mask)] != BLOCK_AIR)
+				break;
+		}
+		height = (float) top + 1;
+	}
+	else {
+		return;
+	}
+
+	// NOTE: only the columns whose walk towards the sun crosses this one change
+	for (int k = 1; k <= HEIGHTMAP_SHADOW_MARCH; ++k) {
+		int cx = x - (int) floorf(k * m_dirX + 0.5f);
+		int cz = z - (int) floorf(k * m_dirZ + 0.5f);
+		if (inside(cx, cz))
+			updateColumn(cx, cz);
+	}
+}
+
+unsigned int HeightmapShadow::texture() {
+	return m_texture;
+}
+
+int HeightmapShadow::originX() {
+	return m_originX;
+}
+
+int HeightmapShadow::originZ() {
+	return m_originZ;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "glad\glad.h"
+#include "glm\glm.hpp"
+
+class World;
+
+#define HEIGHTMAP_SHADOW_SIZE 256          // NOTE: columns per side, one texel per column
+#define HEIGHTMAP_SHADOW_MARCH 64          // NOTE: columns walked towards the sun per texel
+#define HEIGHTMAP_SHADOW_ROWS_PER_FRAME 16
+
+// NOTE: sun shadows of the terrain around the camera from its heightmap. Every texel of the texture holds
+// the height below which its column is in shadow, found by walking the heightmap towards the sun. The texture
+// is toroidal: column (x, z) is always stored at texel (x mod size, z mod size).
+class HeightmapShadow {
+	public:
+		HeightmapShadow();
+		~HeightmapShadow();
+
+		// NOTE: moves the window with the camera and refreshes HEIGHTMAP_SHADOW_ROWS_PER_FRAME rows
+		// for the current sun direction, only changed rows are uploaded
+		void update(float camX, float camZ, glm::vec3 lightDir);
+		void blockChanged(World &world, int x, int y, int z);
+
+		unsigned int texture();
+		int originX();
+		int originZ();
+
+	private:
+		int index(int x, int z);
+		bool inside(int x, int z);
+		void updateColumn(int x, int z);
+
+		float m_heights[HEIGHTMAP_SHADOW_SIZE * HEIGHTMAP_SHADOW_SIZE];
+		float m_occluded[HEIGHTMAP_SHADOW_SIZE * HEIGHTMAP_SHADOW_SIZE];
+		bool m_rowDirty[HEIGHTMAP_SHADOW_SIZE];
+		float m_maxHeight;
+
+		int m_originX, m_originZ;
+		bool m_valid;
+		int m_nextRow;
+
+		float m_dirX, m_dirZ; // NOTE: horizontal direction towards the sun
+		float m_slope;        // NOTE: height the sun ray gains per column
+
+		unsigned int m_texture;
+};
@@ -0,0 +1,77 @@
+#include "HudBatch.h"
+
+HudBatch::HudBatch() : m_numOfVs(0) {
+	glGenVertexArrays(1, &m_vao);
+	glGenBuffers(1, &m_vbo);
+
+	glBindVertexArray(m_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(m_vertices), NULL, GL_STREAM_DRAW);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)(sizeof(float) * 2));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)(sizeof(float) * 4));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)(sizeof(float) * 8));
+	glEnableVertexAttribArray(3);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+HudBatch::~HudBatch() {
+	glDeleteBuffers(1, &m_vbo);
+	glDeleteVertexArrays(1, &m_vao);
+}
+
+void HudBatch::vertex(glm::vec2 pos, glm::vec2 uv, Hud_texture texture, glm::vec4 color) {
+	Vertex &v = m_vertices[m_numOfVs++];
+	v.x = pos.x;
+	v.y = pos.y;
+	v.u = uv.x;
+	v.v = uv.y;
+	v.r = color.r;
+	v.g = color.g;
+	v.b = color.b;
+	v.a = color.a;
+	v.texture = (float) texture;
+}
+
+void HudBatch::quad(glm::vec2 min, glm::vec2 max, glm::vec2 uvMin, glm::vec2 uvMax, Hud_texture texture, glm::vec4 color) {
+	// NOTE: whatever does not fit into the buffer is dropped until the next flush
+	if (m_numOfVs + 6 > HUD_BATCH_MAX_VERTICES)
+		return;
+
+	vertex(glm::vec2(min.x, max.y), glm::vec2(uvMin.x, uvMax.y), texture, color);
+	vertex(glm::vec2(min.x, min.y), glm::vec2(uvMin.x, uvMin.y), texture, color);
+	vertex(glm::vec2(max.x, min.y), glm::vec2(uvMax.x, uvMin.y), texture, color);
+	vertex(glm::vec2(max.x, min.y), glm::vec2(uvMax.x, uvMin.y), texture, color);
+	vertex(glm::vec2(max.x, max.y), glm::vec2(uvMax.x, uvMax.y), texture, color);
+	vertex(glm::vec2(min.x, max.y), glm::vec2(uvMin.x, uvMax.y), texture, color);
+}
+
+void HudBatch::triangle(glm::vec2 a, glm::vec2 b, glm::vec2 c, glm::vec4 color) {
+	if (m_numOfVs + 3 > HUD_BATCH_MAX_VERTICES)
+		return;
+
+	vertex(a, glm::vec2(0.0f), HUD_TEXTURE_NONE, color);
+	vertex(b, glm::vec2(0.0f), HUD_TEXTURE_NONE, color);
+	vertex(c, glm::vec2(0.0f), HUD_TEXTURE_NONE, color);
+}
+
+void HudBatch::flush() {
+	if (!m_numOfVs)
+		return;
+
+	// NOTE: orphan the buffer so the driver does not wait for the previous draw from it
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(m_vertices), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, m_numOfVs * sizeof(Vertex), m_vertices);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glBindVertexArray(m_vao);
+	glDrawArrays(GL_TRIANGLES, 0, m_numOfVs);
+	glBindVertexArray(0);
+
+	m_numOfVs = 0;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "glad\glad.h"
+#include "glm\glm.hpp"
+
+#define HUD_BATCH_MAX_VERTICES 16384
+
+// NOTE: sampler a HUD vertex reads from, HUD_TEXTURE_NONE draws the vertex color only
+enum Hud_texture
+{
+	HUD_TEXTURE_NONE,
+	HUD_TEXTURE_FONT,
+	HUD_TEXTURE_INVENTORY_BAR,
+	HUD_TEXTURE_CROSS,
+	HUD_TEXTURE_LAYER,
+};
+
+// NOTE: collects every HUD triangle of a frame in normalized device coordinates and draws
+// them from one stream buffer, so the cost of the HUD does not depend on how much is on it
+class HudBatch {
+	public:
+		HudBatch();
+		~HudBatch();
+
+		void quad(glm::vec2 min, glm::vec2 max, glm::vec2 uvMin, glm::vec2 uvMax, Hud_texture texture, glm::vec4 color = glm::vec4(1.0f));
+		void triangle(glm::vec2 a, glm::vec2 b, glm::vec2 c, glm::vec4 color);
+
+		// NOTE: draws everything added since the last flush with one draw call
+		void flush();
+
+	private:
+		struct Vertex {
+			float x, y;
+			float u, v;
+			float r, g, b, a;
+			float texture;
+		};
+
+		void vertex(glm::vec2 pos, glm::vec2 uv, Hud_texture texture, glm::vec4 color);
+
+		Vertex m_vertices[HUD_BATCH_MAX_VERTICES];
+		int m_numOfVs;
+
+		GLuint m_vao, m_vbo;
+};
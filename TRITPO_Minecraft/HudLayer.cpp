@@ -0,0 +1,51 @@
+#include "HudLayer.h"
+#include <stddef.h>
+
+HudLayer::HudLayer() : m_width(0), m_height(0) {
+	glGenFramebuffers(1, &m_fbo);
+
+	glGenTextures(1, &m_texture);
+	glBindTexture(GL_TEXTURE_2D, m_texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+HudLayer::~HudLayer() {
+	glDeleteTextures(1, &m_texture);
+	glDeleteFramebuffers(1, &m_fbo);
+}
+
+bool HudLayer::resize(unsigned int width, unsigned int height) {
+	if (width == m_width && height == m_height)
+		return false;
+
+	m_width = width;
+	m_height = height;
+
+	glBindTexture(GL_TEXTURE_2D, m_texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_texture, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	return true;
+}
+
+void HudLayer::bind() {
+	glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void HudLayer::unbind() {
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+unsigned int HudLayer::get() {
+	return m_texture;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "glad\glad.h"
+
+// NOTE: window sized offscreen color target for the parts of the HUD that rarely change.
+// It holds premultiplied alpha, so it is composited with GL_ONE, GL_ONE_MINUS_SRC_ALPHA.
+class HudLayer {
+	public:
+		HudLayer();
+		~HudLayer();
+
+		// NOTE: returns true when the size changed and the contents are gone
+		bool resize(unsigned int width, unsigned int height);
+
+		void bind();
+		void unbind();
+		unsigned int get();
+
+	private:
+		unsigned int m_fbo;
+		unsigned int m_texture;
+		unsigned int m_width, m_height;
+};
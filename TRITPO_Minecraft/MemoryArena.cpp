@@ -0,0 +1,66 @@
+#include "MemoryArena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <assert.h>
+
+void arena_init(Memory_arena *arena, const char *name, void *base, uint64_t size) {
+	*arena = {};
+	arena->name = name;
+	arena->base = (uint8_t*) base;
+	arena->size = size;
+}
+
+void *arena_push(Memory_arena *arena, uint64_t size, uint64_t align) {
+	assert(align && (align & (align - 1)) == 0);
+
+	uint64_t start = ((uint64_t) (arena->base + arena->used) + align - 1) & ~(align - 1);
+	uint64_t offset = start - (uint64_t) arena->base;
+	if (offset > arena->size || size > arena->size - offset) {
+		fprintf(stderr, "Arena %s overflow: %llu bytes requested, %llu of %llu used\n", arena->name,
+			(unsigned long long) size, (unsigned long long) arena->used, (unsigned long long) arena->size);
+		abort();
+	}
+
+	arena->used = offset + size;
+	if (arena->used > arena->frame_high_water)
+		arena->frame_high_water = arena->used;
+	if (arena->used > arena->high_water)
+		arena->high_water = arena->used;
+
+	return arena->base + offset;
+}
+
+char *arena_printf(Memory_arena *arena, const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(NULL, 0, format, args);
+	va_end(args);
+	assert(length >= 0);
+
+	char *text = (char*) arena_push(arena, length + 1, 1);
+	va_start(args, format);
+	vsnprintf(text, length + 1, format, args);
+	va_end(args);
+
+	return text;
+}
+
+Arena_mark arena_mark(const Memory_arena *arena) {
+	return arena->used;
+}
+
+void arena_rewind(Memory_arena *arena, Arena_mark mark) {
+	assert(mark <= arena->used);
+	arena->used = mark;
+}
+
+void arena_reset(Memory_arena *arena) {
+	arena->used = 0;
+}
+
+// NOTE: only rolls the statistics over, the scratch arenas keep what is pushed on them
+void arena_next_frame(Memory_arena *arena) {
+	arena->last_frame_high_water = arena->frame_high_water;
+	arena->frame_high_water = arena->used;
+}
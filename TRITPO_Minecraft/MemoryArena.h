@@ -0,0 +1,40 @@
+#pragma once
+#include <stdint.h>
+
+// NOTE: bump allocator over a fixed block. Memory is given back by rewinding to a mark or by
+// resetting the whole arena, an arena is only ever used by one thread at a time.
+struct Memory_arena
+{
+	const char *name; // NOTE: shown when the arena overflows
+	uint8_t *base;
+	uint64_t size;
+	uint64_t used;
+
+	uint64_t high_water;            // NOTE: most bytes in use at once since arena_init
+	uint64_t frame_high_water;      // NOTE: since the last arena_next_frame
+	uint64_t last_frame_high_water;
+};
+
+typedef uint64_t Arena_mark;
+
+void arena_init(Memory_arena *arena, const char *name, void *base, uint64_t size);
+// NOTE: never fails, running out of the arena reports the arena and aborts
+void *arena_push(Memory_arena *arena, uint64_t size, uint64_t align = 16);
+char *arena_printf(Memory_arena *arena, const char *format, ...);
+Arena_mark arena_mark(const Memory_arena *arena);
+void arena_rewind(Memory_arena *arena, Arena_mark mark);
+void arena_reset(Memory_arena *arena);
+void arena_next_frame(Memory_arena *arena);
+
+#define ARENA_PUSH_ARRAY(arena, type, count) ((type*) arena_push((arena), sizeof(type) * (uint64_t) (count), alignof(type)))
+
+// NOTE: gives back everything pushed while the scope was alive
+class Arena_scope {
+	public:
+		explicit Arena_scope(Memory_arena *arena) : m_arena(arena), m_mark(arena_mark(arena)) {}
+		~Arena_scope() { arena_rewind(m_arena, m_mark); }
+
+	private:
+		Memory_arena *m_arena;
+		Arena_mark m_mark;
+};
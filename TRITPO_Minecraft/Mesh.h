@@ -1,10 +1,21 @@
 #pragma once
 
 #include "glad\glad.h"
+#include "Mesher.h"
 
 struct Mesh
 {
     int num_of_vs;
+    int capacity;  // NOTE: vertices the vbo has room for, normals start at capacity
+    int dead_vs;   // NOTE: degenerate vertices left behind by in-place edits
+
+    // NOTE: vertices are grouped by face direction, face f draws face_vs[f] vertices
+    // from face_first[f] and has room for face_capacity[f]
+    int face_first[FACE_COUNT];
+    int face_vs[FACE_COUNT];
+    int face_capacity[FACE_COUNT];
+
     GLuint vao;
     GLuint vbo;
+    int buffer_bytes; // NOTE: size of the vbo storage, kept for the VRAM estimate
 };
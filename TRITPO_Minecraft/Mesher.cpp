@@ -0,0 +1,665 @@
+#include "Mesher.h"
+#include <assert.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MESHER_SSE2 1
+#include <emmintrin.h>
+#else
+#define MESHER_SSE2 0
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+void gen_ranges_3d(uint8_t *blocks, Range3d *ranges, uint8_t *visited, int dim, int count, int *num_of_ranges)
+{
+    int ranges_count = 0;
+
+    while (count > 0)
+    {
+        int start_z = 0;
+        int end_z = 0;
+
+        int start_y = 0;
+        int end_y = 0;
+
+        int start_x = 0;
+        int end_x = 0;
+
+        // skip all visited and empty blocks
+        for (start_y = 0; start_y < dim; start_y++)
+        {
+            for (start_z = 0; start_z < dim; start_z++)
+            {
+                for (start_x = 0; start_x < dim; start_x++)
+                {
+                    if (visited[start_y * dim * dim + start_z * dim + start_x] == 0 &&
+                        blocks[start_y * dim * dim + start_z * dim + start_x] != BLOCK_AIR)
+                    {
+                        goto break1;
+                    }
+                }
+            }
+        }
+    break1:
+
+        // If a block at (start_x, start_y, start_z) is in the grid (the grid is not empty), mark it as visited.
+        // Also record block type.
+        uint8_t block_type = BLOCK_AIR;
+        if (start_x < dim && start_y < dim && start_z < dim)
+        {
+            visited[start_y * dim * dim + start_z * dim + start_x] = 1;
+            block_type = blocks[start_y * dim * dim + start_z * dim + start_x];
+            count--;
+        }
+
+        // try expand in x direction
+        end_x = start_x;
+        while ((end_x + 1 < dim) &&
+            (blocks[start_y * dim * dim + start_z * dim + (end_x + 1)] == block_type) &&
+            (visited[start_y * dim * dim + start_z * dim + (end_x + 1)] == 0))
+        {
+            visited[start_y * dim * dim + start_z * dim + (end_x + 1)] = 1;
+            end_x++;
+            count--;
+        }
+
+        // try expand in z direction
+        end_z = start_z;
+        while (end_z + 1 < dim)
+        {
+            bool can_expand = true;
+            for (int x = start_x; x <= end_x; x++)
+            {
+                if (blocks[start_y * dim * dim + (end_z + 1) * dim + x] != block_type ||
+                    visited[start_y * dim * dim + (end_z + 1) * dim + x] == 1)
+                {
+                    can_expand = false;
+                    break;
+                }
+            }
+
+            if (can_expand)
+            {
+                // mark expanded row of block as visited
+                for (int x = start_x; x <= end_x; x++)
+                {
+                    visited[start_y * dim * dim + (end_z + 1) * dim + x] = 1;
+                }
+                end_z++;
+                count -= end_x - start_x + 1;
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        // try expand in y direction
+        end_y = start_y;
+        while (end_y + 1 < dim)
+        {
+            bool can_expand = true;
+            for (int z = start_z; z <= end_z; z++)
+            {
+                for (int x = start_x; x <= end_x; x++)
+                {
+                    if (blocks[(end_y + 1) * dim * dim + z * dim + x] != block_type ||
+                        visited[(end_y + 1) * dim * dim + z * dim + x] == 1)
+                    {
+                        can_expand = false;
+                        goto break2;
+                    }
+                }
+            }
+        break2:
+            if (can_expand)
+            {
+                for (int z = start_z; z <= end_z; z++)
+                {
+                    for (int x = start_x; x <= end_x; x++)
+                    {
+                        visited[(end_y + 1) * dim * dim + z * dim + x] = 1;
+                    }
+                }
+                end_y++;
+                count -= (end_x - start_x + 1) * (end_z - start_z + 1);
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        assert(block_type != BLOCK_AIR);
+        ranges[ranges_count++] = { block_type, ALL_FACES, start_x, start_y, start_z, end_x, end_y, end_z };
+    }
+
+    assert(count == 0);
+    *num_of_ranges = ranges_count;
+}
+
+void gen_ranges_naive(uint8_t *blocks, Range3d *ranges, int dim, int *num_of_ranges)
+{
+    int ranges_count = 0;
+
+    for (int y = 0; y < dim; y++)
+    {
+        for (int z = 0; z < dim; z++)
+        {
+            for (int x = 0; x < dim; x++)
+            {
+                uint8_t block_type = blocks[y * dim * dim + z * dim + x];
+                if (block_type != BLOCK_AIR)
+                {
+                    ranges[ranges_count++] = { block_type, ALL_FACES, x, y, z, x, y, z };
+                }
+            }
+        }
+    }
+
+    *num_of_ranges = ranges_count;
+}
+
+inline int ctz32(uint32_t x)
+{
+    assert(x != 0);
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, x);
+    return ((int)index);
+#else
+    return (__builtin_ctz(x));
+#endif
+}
+
+void build_chunk_masks(const uint8_t *blocks, Chunk_masks *masks)
+{
+    uint16_t *solid = masks->solid_padded + MASK_DIM;
+
+    for (int i = 0; i < MASK_DIM; i++)
+    {
+        masks->solid_padded[i] = 0;
+        masks->solid_padded[MASK_DIM + MASK_ROWS + i] = 0;
+    }
+
+    // NOTE: one row of blocks is 16 bytes, compare all of them against every type at once
+    for (int row = 0; row < MASK_ROWS; row++)
+    {
+        const uint8_t *row_blocks = blocks + row * MASK_DIM;
+#if MESHER_SSE2
+        __m128i v = _mm_loadu_si128((const __m128i *)row_blocks);
+        for (int t = 0; t < BLOCK_TYPE_COUNT; t++)
+        {
+            masks->types[t][row] = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8((char)t)));
+        }
+        uint16_t air = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8((char)BLOCK_AIR)));
+        solid[row] = (uint16_t)~air;
+#else
+        for (int t = 0; t < BLOCK_TYPE_COUNT; t++)
+        {
+            masks->types[t][row] = 0;
+        }
+        uint16_t solid_row = 0;
+        for (int x = 0; x < MASK_DIM; x++)
+        {
+            uint8_t type = row_blocks[x];
+            if (type != BLOCK_AIR)
+            {
+                masks->types[type][row] |= (uint16_t)(1 << x);
+                solid_row |= (uint16_t)(1 << x);
+            }
+        }
+        solid[row] = solid_row;
+#endif
+    }
+
+    // NOTE: exposed faces for 8 rows at a time, z neighbours of the first and the last row
+    // of every 16-row layer lie outside of the chunk and are masked out
+#if MESHER_SSE2
+    const __m128i keep_north[2] = {
+        _mm_set_epi16(-1, -1, -1, -1, -1, -1, -1, 0),
+        _mm_set1_epi16(-1),
+    };
+    const __m128i keep_south[2] = {
+        _mm_set1_epi16(-1),
+        _mm_set_epi16(0, -1, -1, -1, -1, -1, -1, -1),
+    };
+
+    for (int row = 0; row < MASK_ROWS; row += 8)
+    {
+        int half = (row / 8) & 1;
+        __m128i s      = _mm_loadu_si128((const __m128i *)(solid + row));
+        __m128i below  = _mm_loadu_si128((const __m128i *)(solid + row - MASK_DIM));
+        __m128i above  = _mm_loadu_si128((const __m128i *)(solid + row + MASK_DIM));
+        __m128i north  = _mm_and_si128(_mm_loadu_si128((const __m128i *)(solid + row - 1)), keep_north[half]);
+        __m128i south  = _mm_and_si128(_mm_loadu_si128((const __m128i *)(solid + row + 1)), keep_south[half]);
+
+        _mm_storeu_si128((__m128i *)(masks->exposed[FACE_BOTTOM] + row), _mm_andnot_si128(below, s));
+        _mm_storeu_si128((__m128i *)(masks->exposed[FACE_TOP] + row), _mm_andnot_si128(above, s));
+        _mm_storeu_si128((__m128i *)(masks->exposed[FACE_NORTH] + row), _mm_andnot_si128(north, s));
+        _mm_storeu_si128((__m128i *)(masks->exposed[FACE_SOUTH] + row), _mm_andnot_si128(south, s));
+        _mm_storeu_si128((__m128i *)(masks->exposed[FACE_WEST] + row), _mm_andnot_si128(_mm_slli_epi16(s, 1), s));
+        _mm_storeu_si128((__m128i *)(masks->exposed[FACE_EAST] + row), _mm_andnot_si128(_mm_srli_epi16(s, 1), s));
+    }
+#else
+    for (int row = 0; row < MASK_ROWS; row++)
+    {
+        int z = row % MASK_DIM;
+        uint16_t s = solid[row];
+        uint16_t north = (z > 0) ? solid[row - 1] : 0;
+        uint16_t south = (z < MASK_DIM - 1) ? solid[row + 1] : 0;
+
+        masks->exposed[FACE_BOTTOM][row] = s & ~solid[row - MASK_DIM];
+        masks->exposed[FACE_TOP][row] = s & ~solid[row + MASK_DIM];
+        masks->exposed[FACE_NORTH][row] = s & ~north;
+        masks->exposed[FACE_SOUTH][row] = s & ~south;
+        masks->exposed[FACE_WEST][row] = s & ~(uint16_t)(s << 1);
+        masks->exposed[FACE_EAST][row] = s & ~(uint16_t)(s >> 1);
+    }
+#endif
+}
+
+uint8_t range_exposed_faces(const Chunk_masks *masks, const Range3d *range)
+{
+    uint32_t run = ((1u << (range->end_x - range->start_x + 1)) - 1) << range->start_x;
+    uint32_t bottom = 0, top = 0, north = 0, south = 0, west = 0, east = 0;
+
+    for (int z = range->start_z; z <= range->end_z; z++)
+    {
+        bottom |= masks->exposed[FACE_BOTTOM][MASK_DIM * range->start_y + z];
+        top    |= masks->exposed[FACE_TOP][MASK_DIM * range->end_y + z];
+    }
+
+    for (int y = range->start_y; y <= range->end_y; y++)
+    {
+        north |= masks->exposed[FACE_NORTH][MASK_DIM * y + range->start_z];
+        south |= masks->exposed[FACE_SOUTH][MASK_DIM * y + range->end_z];
+
+        for (int z = range->start_z; z <= range->end_z; z++)
+        {
+            west |= masks->exposed[FACE_WEST][MASK_DIM * y + z];
+            east |= masks->exposed[FACE_EAST][MASK_DIM * y + z];
+        }
+    }
+
+    uint8_t faces = 0;
+    if (bottom & run) faces |= (1 << FACE_BOTTOM);
+    if (top & run) faces |= (1 << FACE_TOP);
+    if (north & run) faces |= (1 << FACE_NORTH);
+    if (south & run) faces |= (1 << FACE_SOUTH);
+    if (west & (1u << range->start_x)) faces |= (1 << FACE_WEST);
+    if (east & (1u << range->end_x)) faces |= (1 << FACE_EAST);
+
+    return (faces);
+}
+
+void gen_ranges_bitmask(const uint8_t *blocks, Range3d *ranges, Chunk_masks *masks, int *num_of_ranges)
+{
+    build_chunk_masks(blocks, masks);
+    memset(masks->visited, 0, sizeof(masks->visited));
+
+    const uint16_t *solid = masks->solid_padded + MASK_DIM;
+    uint16_t *visited = masks->visited;
+    int ranges_count = 0;
+
+    // NOTE: rows are scanned once in the same y, z, x order as gen_ranges_3d,
+    // ranges only ever mark rows at or after the current one as visited
+    for (int start_y = 0; start_y < MASK_DIM; start_y++)
+    {
+        for (int start_z = 0; start_z < MASK_DIM; start_z++)
+        {
+            int row = MASK_DIM * start_y + start_z;
+
+            uint32_t left = solid[row] & ~visited[row];
+            while (left)
+            {
+                int start_x = ctz32(left);
+                uint8_t block_type = blocks[row * MASK_DIM + start_x];
+                const uint16_t *type_rows = masks->types[block_type];
+
+                // expand in x direction: length of the run of free blocks of this type
+                uint32_t free_of_type = type_rows[row] & ~visited[row];
+                int len = ctz32(~(free_of_type >> start_x));
+                uint16_t run = (uint16_t)(((1u << len) - 1) << start_x);
+
+                // expand in z direction
+                int end_z = start_z;
+                while (end_z + 1 < MASK_DIM)
+                {
+                    int next = MASK_DIM * start_y + end_z + 1;
+                    if ((type_rows[next] & ~visited[next] & run) != run) break;
+                    end_z++;
+                }
+
+                // expand in y direction
+                int end_y = start_y;
+                while (end_y + 1 < MASK_DIM)
+                {
+                    uint16_t all = run;
+                    for (int z = start_z; z <= end_z; z++)
+                    {
+                        int next = MASK_DIM * (end_y + 1) + z;
+                        all &= type_rows[next] & ~visited[next];
+                    }
+                    if (all != run) break;
+                    end_y++;
+                }
+
+                for (int y = start_y; y <= end_y; y++)
+                {
+                    for (int z = start_z; z <= end_z; z++)
+                    {
+                        visited[MASK_DIM * y + z] |= run;
+                    }
+                }
+                left &= ~(uint32_t)run;
+
+                Range3d *r = &ranges[ranges_count++];
+                *r = { block_type, 0, start_x, start_y, start_z, start_x + len - 1, end_y, end_z };
+                r->faces = range_exposed_faces(masks, r);
+            }
+        }
+    }
+
+    *num_of_ranges = ranges_count;
+}
+
+uint64_t gen_face_connectivity(const uint8_t *blocks, Chunk_masks *masks)
+{
+    uint64_t connectivity = 0;
+    uint16_t *visited = masks->visited;
+    uint16_t *stack = masks->flood_stack;
+    memset(visited, 0, sizeof(masks->visited));
+
+    for (int start = 0; start < MASK_DIM * MASK_ROWS; start++)
+    {
+        if (blocks[start] != BLOCK_AIR || (visited[start >> 4] & (1 << (start & 15))))
+            continue;
+
+        int faces = 0;
+        int top = 0;
+        stack[top++] = (uint16_t)start;
+        visited[start >> 4] |= 1 << (start & 15);
+
+        while (top > 0)
+        {
+            int i = stack[--top];
+            int x = i & 15;
+            int z = (i >> 4) & 15;
+            int y = i >> 8;
+
+            if (x == 0)            faces |= 1 << FACE_WEST;
+            if (x == MASK_DIM - 1) faces |= 1 << FACE_EAST;
+            if (y == 0)            faces |= 1 << FACE_BOTTOM;
+            if (y == MASK_DIM - 1) faces |= 1 << FACE_TOP;
+            if (z == 0)            faces |= 1 << FACE_NORTH;
+            if (z == MASK_DIM - 1) faces |= 1 << FACE_SOUTH;
+
+            int neighbours[FACE_COUNT];
+            int count = 0;
+            if (x > 0)            neighbours[count++] = i - 1;
+            if (x < MASK_DIM - 1) neighbours[count++] = i + 1;
+            if (z > 0)            neighbours[count++] = i - MASK_DIM;
+            if (z < MASK_DIM - 1) neighbours[count++] = i + MASK_DIM;
+            if (y > 0)            neighbours[count++] = i - MASK_ROWS;
+            if (y < MASK_DIM - 1) neighbours[count++] = i + MASK_ROWS;
+
+            for (int n = 0; n < count; n++)
+            {
+                int ni = neighbours[n];
+                if (blocks[ni] == BLOCK_AIR && !(visited[ni >> 4] & (1 << (ni & 15))))
+                {
+                    visited[ni >> 4] |= 1 << (ni & 15);
+                    stack[top++] = (uint16_t)ni;
+                }
+            }
+        }
+
+        for (int a = 0; a < FACE_COUNT; a++)
+        {
+            if (!(faces & (1 << a))) continue;
+
+            for (int b = 0; b < FACE_COUNT; b++)
+            {
+                if (faces & (1 << b)) connectivity |= FACE_PAIR_BIT(a, b);
+            }
+        }
+
+        if (connectivity == ALL_FACES_CONNECTED)
+            break;
+    }
+
+    return (connectivity);
+}
+
+void downsample_blocks(const uint8_t *blocks, uint8_t *out, int lod)
+{
+    assert(lod >= 0 && lod <= MAX_LOD);
+
+    int cell = 1 << lod;
+    int cell_volume = cell * cell * cell;
+
+    for (int cy = 0; cy < MASK_DIM; cy += cell)
+    {
+        for (int cz = 0; cz < MASK_DIM; cz += cell)
+        {
+            for (int cx = 0; cx < MASK_DIM; cx += cell)
+            {
+                int counts[BLOCK_TYPE_COUNT] = {};
+                int solid = 0;
+
+                for (int y = cy; y < cy + cell; y++)
+                {
+                    for (int z = cz; z < cz + cell; z++)
+                    {
+                        for (int x = cx; x < cx + cell; x++)
+                        {
+                            uint8_t type = blocks[MASK_ROWS * y + MASK_DIM * z + x];
+                            if (type != BLOCK_AIR)
+                            {
+                                counts[type]++;
+                                solid++;
+                            }
+                        }
+                    }
+                }
+
+                uint8_t cell_type = BLOCK_AIR;
+                if (solid && solid * 2 >= cell_volume)
+                {
+                    cell_type = 0;
+                    for (int t = 1; t < BLOCK_TYPE_COUNT; t++)
+                    {
+                        if (counts[t] > counts[cell_type]) cell_type = t;
+                    }
+                }
+
+                for (int y = cy; y < cy + cell; y++)
+                {
+                    for (int z = cz; z < cz + cell; z++)
+                    {
+                        memset(&out[MASK_ROWS * y + MASK_DIM * z + cx], cell_type, cell);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void sort_ranges_by_type(Range3d *ranges, int count)
+{
+    int type_start[BLOCK_TYPE_COUNT + 1] = {};
+    for (int i = 0; i < count; i++)
+    {
+        type_start[ranges[i].type + 1]++;
+    }
+    for (int t = 0; t < BLOCK_TYPE_COUNT; t++)
+    {
+        type_start[t + 1] += type_start[t];
+    }
+
+    // NOTE: swap every range into the next free slot of its type's bucket
+    int next[BLOCK_TYPE_COUNT];
+    for (int t = 0; t < BLOCK_TYPE_COUNT; t++)
+    {
+        next[t] = type_start[t];
+    }
+
+    for (int t = 0; t < BLOCK_TYPE_COUNT; t++)
+    {
+        while (next[t] < type_start[t + 1])
+        {
+            Range3d *r = &ranges[next[t]];
+            if (r->type == t)
+            {
+                next[t]++;
+            }
+            else
+            {
+                Range3d temp = ranges[next[r->type]];
+                ranges[next[r->type]++] = *r;
+                *r = temp;
+            }
+        }
+    }
+}
+
+static void set_face_normals(Vec3f *ns, Vec3f n)
+{
+    for (int i = 0; i < VERTICES_PER_FACE; i++)
+    {
+        ns[i] = n;
+    }
+}
+
+int gen_range_vertices(const Range3d *range, Vec3f *vs, Vec3f *ns)
+{
+    return gen_range_face_vertices(range, range->faces, vs, ns);
+}
+
+int gen_range_face_vertices(const Range3d *range, uint8_t faces, Vec3f *vs, Vec3f *ns)
+{
+    Vec3f base((float)range->start_x, (float)range->start_y, (float)range->start_z);
+
+    float dim_x = (float)range->end_x - base.x + 1.0f;
+    float dim_y = (float)range->end_y - base.y + 1.0f;
+    float dim_z = (float)range->end_z - base.z + 1.0f;
+
+    // TODO(max): check for correct winding order
+
+    Vec3f bottom_n(0, -1, 0);
+    Vec3f top_n(0, 1, 0);
+    Vec3f north_n(0, 0, -1);
+    Vec3f south_n(0, 0, 1);
+    Vec3f west_n(-1, 0, 0);
+    Vec3f east_n(1, 0, 0);
+
+    int v = 0;
+
+    if (faces & (1 << FACE_BOTTOM))
+    {
+        // bottom tri 0
+        vs[v + 0 * 3 + 0] = base;
+        vs[v + 0 * 3 + 1] = base + Vec3f(dim_x, 0, 0);
+        vs[v + 0 * 3 + 2] = base + Vec3f(0, 0, dim_z);
+
+        // bottom tri 1
+        vs[v + 1 * 3 + 0] = base + Vec3f(0, 0, dim_z);
+        vs[v + 1 * 3 + 1] = base + Vec3f(dim_x, 0, 0);
+        vs[v + 1 * 3 + 2] = base + Vec3f(dim_x, 0, dim_z);
+
+        if (ns) set_face_normals(ns + v, bottom_n);
+
+        v += 6;
+    }
+
+    if (faces & (1 << FACE_TOP))
+    {
+        // top tri 0
+        vs[v + 0 * 3 + 0] = base + Vec3f(0, dim_y, 0);
+        vs[v + 0 * 3 + 1] = base + Vec3f(0, dim_y, dim_z);
+        vs[v + 0 * 3 + 2] = base + Vec3f(dim_x, dim_y, 0);
+
+        // top tri 1
+        vs[v + 1 * 3 + 0] = base + Vec3f(0, dim_y, dim_z);
+        vs[v + 1 * 3 + 1] = base + Vec3f(dim_x, dim_y, dim_z);
+        vs[v + 1 * 3 + 2] = base + Vec3f(dim_x, dim_y, 0);
+
+        if (ns) set_face_normals(ns + v, top_n);
+
+        v += 6;
+    }
+
+    if (faces & (1 << FACE_NORTH))
+    {
+        // north tri 0
+        vs[v + 0 * 3 + 0] = base;
+        vs[v + 0 * 3 + 1] = base + Vec3f(0, dim_y, 0);
+        vs[v + 0 * 3 + 2] = base + Vec3f(dim_x, dim_y, 0);
+
+        // north tri 1
+        vs[v + 1 * 3 + 0] = base;
+        vs[v + 1 * 3 + 1] = base + Vec3f(dim_x, dim_y, 0);
+        vs[v + 1 * 3 + 2] = base + Vec3f(dim_x, 0, 0);
+
+        if (ns) set_face_normals(ns + v, north_n);
+
+        v += 6;
+    }
+
+    if (faces & (1 << FACE_SOUTH))
+    {
+        // south tri 0
+        vs[v + 0 * 3 + 0] = base + Vec3f(0, 0, dim_z);
+        vs[v + 0 * 3 + 1] = base + Vec3f(dim_x, dim_y, dim_z);
+        vs[v + 0 * 3 + 2] = base + Vec3f(0, dim_y, dim_z);
+
+        // south tri 1
+        vs[v + 1 * 3 + 0] = base + Vec3f(0, 0, dim_z);
+        vs[v + 1 * 3 + 1] = base + Vec3f(dim_x, 0, dim_z);
+        vs[v + 1 * 3 + 2] = base + Vec3f(dim_x, dim_y, dim_z);
+
+        if (ns) set_face_normals(ns + v, south_n);
+
+        v += 6;
+    }
+
+    if (faces & (1 << FACE_WEST))
+    {
+        // west tri 0
+        vs[v + 0 * 3 + 0] = base;
+        vs[v + 0 * 3 + 1] = base + Vec3f(0, dim_y, dim_z);
+        vs[v + 0 * 3 + 2] = base + Vec3f(0, dim_y, 0);
+
+        // west tri 1
+        vs[v + 1 * 3 + 0] = base;
+        vs[v + 1 * 3 + 1] = base + Vec3f(0, 0, dim_z);
+        vs[v + 1 * 3 + 2] = base + Vec3f(0, dim_y, dim_z);
+
+        if (ns) set_face_normals(ns + v, west_n);
+
+        v += 6;
+    }
+
+    if (faces & (1 << FACE_EAST))
+    {
+        // east tri 0
+        vs[v + 0 * 3 + 0] = base + Vec3f(dim_x, 0, 0);
+        vs[v + 0 * 3 + 1] = base + Vec3f(dim_x, dim_y, 0);
+        vs[v + 0 * 3 + 2] = base + Vec3f(dim_x, dim_y, dim_z);
+
+        // east tri 1
+        vs[v + 1 * 3 + 0] = base + Vec3f(dim_x, 0, 0);
+        vs[v + 1 * 3 + 1] = base + Vec3f(dim_x, dim_y, dim_z);
+        vs[v + 1 * 3 + 2] = base + Vec3f(dim_x, 0, dim_z);
+
+        if (ns) set_face_normals(ns + v, east_n);
+
+        v += 6;
+    }
+
+    return (v);
+}
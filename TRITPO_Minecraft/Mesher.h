@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include "3DMath.h"
+#include "Blocks.h"
+
+// NOTE: a range is emitted as a box of at most 12 triangles, two per face in faces
+#define VERTICES_PER_FACE (3 * 2)
+#define VERTICES_PER_RANGE (VERTICES_PER_FACE * FACE_COUNT)
+
+// NOTE: the bitmask mesher works on 16^3 chunks, one uint16_t per row of 16 blocks along x
+#define MASK_DIM 16
+#define MASK_ROWS (MASK_DIM * MASK_DIM)
+
+enum Face
+{
+    FACE_BOTTOM, // -y
+    FACE_TOP,    // +y
+    FACE_NORTH,  // -z
+    FACE_SOUTH,  // +z
+    FACE_WEST,   // -x
+    FACE_EAST,   // +x
+
+    FACE_COUNT,
+};
+
+#define ALL_FACES ((1 << FACE_COUNT) - 1)
+
+struct Range3d
+{
+    uint8_t type;
+    uint8_t faces; // NOTE: bit (1 << Face) is set for every face that has to be drawn
+
+    int start_x;
+    int start_y;
+    int start_z;
+
+    int end_x;
+    int end_y;
+    int end_z;
+};
+
+// NOTE: blocks are laid out as blocks[dim * dim * y + dim * z + x], visited must be zeroed by the caller
+void gen_ranges_3d(uint8_t *blocks, Range3d *ranges, uint8_t *visited, int dim, int count, int *num_of_ranges);
+
+// NOTE: reference mesher, emits one range per solid block
+void gen_ranges_naive(uint8_t *blocks, Range3d *ranges, int dim, int *num_of_ranges);
+
+// NOTE: row masks of a 16^3 chunk, row index is MASK_DIM * y + z and bit x of a row is block x.
+// solid is padded with one empty layer below and above, so y - 1 and y + 1 rows can be read
+// without bounds checks.
+struct Chunk_masks
+{
+    uint16_t types[BLOCK_TYPE_COUNT][MASK_ROWS];
+    uint16_t solid_padded[MASK_DIM + MASK_ROWS + MASK_DIM];
+    uint16_t exposed[FACE_COUNT][MASK_ROWS]; // solid blocks whose neighbour in that direction is air
+    uint16_t visited[MASK_ROWS];
+    uint16_t flood_stack[MASK_DIM * MASK_ROWS];
+};
+
+// NOTE: builds the masks of blocks[MASK_DIM * MASK_DIM * y + MASK_DIM * z + x],
+// faces on the chunk border are always exposed
+void build_chunk_masks(const uint8_t *blocks, Chunk_masks *masks);
+
+// NOTE: same ranges as gen_ranges_3d for dim == MASK_DIM, but found with row bitmasks,
+// and only exposed faces are kept in Range3d::faces
+void gen_ranges_bitmask(const uint8_t *blocks, Range3d *ranges, Chunk_masks *masks, int *num_of_ranges);
+
+// NOTE: bit of a face pair in the result of gen_face_connectivity
+#define FACE_PAIR_BIT(a, b) (1ull << ((a) * FACE_COUNT + (b)))
+#define ALL_FACES_CONNECTED ((1ull << (FACE_COUNT * FACE_COUNT)) - 1)
+
+// NOTE: flood fills the air of a 16^3 chunk, FACE_PAIR_BIT(a, b) is set when air touching
+// face a and air touching face b are connected, so the chunk can be seen through from a to b
+uint64_t gen_face_connectivity(const uint8_t *blocks, Chunk_masks *masks);
+
+// NOTE: coarser meshes for far chunks, LOD n merges cells of 2^n blocks per side
+#define MAX_LOD 2
+
+// NOTE: replaces every 2^lod cell of a 16^3 chunk with its majority block type, the cell
+// stays solid when at least half of it is solid. out keeps the 16^3 layout, so it can be
+// meshed like any other chunk and the ranges come out aligned to cells.
+void downsample_blocks(const uint8_t *blocks, uint8_t *out, int lod);
+
+// NOTE: groups ranges by type in place, in O(count)
+void sort_ranges_by_type(Range3d *ranges, int count);
+
+// NOTE: faces of the range that have at least one exposed block
+uint8_t range_exposed_faces(const Chunk_masks *masks, const Range3d *range);
+
+inline int range_vertex_count(const Range3d *range)
+{
+    int faces = 0;
+    for (int f = 0; f < FACE_COUNT; f++)
+    {
+        if (range->faces & (1 << f)) faces++;
+    }
+
+    return (faces * VERTICES_PER_FACE);
+}
+
+// NOTE: writes range_vertex_count(range) positions and normals, returns the number of vertices written.
+// ns can be nullptr for positions only
+int gen_range_vertices(const Range3d *range, Vec3f *vs, Vec3f *ns);
+
+// NOTE: same as gen_range_vertices for the given faces only, in Face order
+int gen_range_face_vertices(const Range3d *range, uint8_t faces, Vec3f *vs, Vec3f *ns);
@@ -1,68 +1,363 @@
 #pragma once
 
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <atomic>
+#include <mutex>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// NOTE: index of the lowest set bit, x can't be 0
+inline int pool_ctz64(uint64_t x) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, x);
+	return (int) index;
+#else
+	return __builtin_ctzll(x);
+#endif
+}
+
+// NOTE: first bit of size clear bits in a row, -1 if there are none. Works a word at a time,
+// the bits past nbits in the last word have to be set.
+inline int pool_find_clear_run(const uint64_t *bits, int nbits, int size) {
+	int run_start = 0;
+	int run_length = 0;
+
+	for (int w = 0; w < (nbits + 63) / 64; ++w) {
+		uint64_t word = bits[w];
+		if (word == ~0ull) {
+			run_length = 0;
+			continue;
+		}
+
+		int bit = 0;
+		while (bit < 64) {
+			uint64_t rest = word >> bit;
+			int clear = (rest == 0) ? 64 - bit : pool_ctz64(rest);
+			if (clear > 0) {
+				if (run_length == 0)
+					run_start = w * 64 + bit;
+				run_length += clear;
+				if (run_length >= size)
+					return run_start;
+				bit += clear;
+			}
+			if (bit == 64)
+				break;
+
+			// NOTE: word >> bit has zeros shifted in at the top, so its complement is never 0
+			bit += pool_ctz64(~(word >> bit));
+			run_length = 0;
+		}
+	}
+
+	return -1;
+}
+
+// NOTE: sets or clears the bits from first to first + count - 1
+inline void pool_set_bits(uint64_t *bits, int first, int count, bool set) {
+	while (count > 0) {
+		int w = first / 64;
+		int bit = first % 64;
+		int n = (count < 64 - bit) ? count : 64 - bit;
+		uint64_t mask = ((n == 64) ? ~0ull : ((1ull << n) - 1)) << bit;
+
+		if (set)
+			bits[w] |= mask;
+		else
+			bits[w] &= ~mask;
+
+		first += n;
+		count -= n;
+	}
+}
+
+struct Pool_stats
+{
+	int used;
+	int high_water;
+	int capacity;      // NOTE: blocks in the pages allocated so far
+	int pages;
+	int run_pages;     // NOTE: pages that hand out contiguous runs
+	int64_t mallocs;
+	int64_t frees;
+	int64_t failed;    // NOTE: mallocs that found every page full and no room for another page
+	int64_t cas_retries;
+};
+
+// NOTE: fixed size blocks in pages of page_blocks blocks, a new page is allocated when every page is full.
+// malloc() and free() are lock-free and can be called from any thread, only adding a page takes a lock.
+// Pages are never given back, so blocks keep their address until they are freed.
+// Runs of adjacent blocks come from separate run pages that track their blocks in an occupancy
+// bitmap instead of the free list, those take a lock of their own.
 template<class T>
 class PoolAllocator {
-	static_assert(sizeof(T) >= sizeof(T*), "Only data types with sizeof(T*) >= sizeof(T) are supported");
-	
 	public:
-		explicit PoolAllocator(T *memory, int size) : m_memory(memory), m_size(size) {
-			m_first_free_block = nullptr;
+		explicit PoolAllocator(int page_blocks, int max_pages) : m_page_blocks(page_blocks), m_max_pages(max_pages) {
+			assert(page_blocks > 0 && max_pages > 0);
+			assert((int64_t) page_blocks * max_pages < UINT32_MAX);
 
-			free(memory, size);
+			m_pages = (Page*) calloc(max_pages, sizeof(Page));
+			m_npages = 0;
+			m_run_pages = 0;
+			m_free_head = 0;
+			m_used = 0;
+			m_high_water = 0;
+			m_mallocs = 0;
+			m_frees = 0;
+			m_failed = 0;
+			m_cas_retries = 0;
 		}
 
-		T* malloc() {
-			T* tmp = m_first_free_block;
-			T** header = (T**) m_first_free_block;
-			m_first_free_block = *header;
-
-			return tmp;
+		~PoolAllocator() {
+			for (int i = 0; i < m_npages; ++i) {
+				::free(m_pages[i].blocks);
+				::free(m_pages[i].next);
+				::free(m_pages[i].occupied);
+			}
+			::free(m_pages);
 		}
 
-		T* malloc(int size) {
-			T** pointer_to_edit = &m_first_free_block;
-			T* start_block = m_first_free_block;
-			T* end_block = m_first_free_block;
-			int consecutive_blocks_found = 1;
-
-			while (consecutive_blocks_found < size && end_block != nullptr) {
-				T** end_header = (T**) end_block;
-				T* next_block = *end_header;
-
-				if (end_block + 1 == next_block) {
-					consecutive_blocks_found++;
-					end_block = next_block;
+		PoolAllocator(const PoolAllocator&) = delete;
+		PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+		// NOTE: nullptr once max_pages pages are full
+		T* malloc() {
+			uint64_t head = m_free_head.load(std::memory_order_acquire);
+			for (;;) {
+				uint32_t first = (uint32_t) head;
+				if (first == 0) {
+					if (!grow())
+						return nullptr;
+					head = m_free_head.load(std::memory_order_acquire);
+					continue;
 				}
-				else {
-					pointer_to_edit = (T**) end_block;
-					consecutive_blocks_found = 1;
-					start_block = next_block;
-					end_block = next_block;
+
+				// NOTE: the tag in the upper half changes on every push and pop, so a head that was
+				// popped and pushed back in the meantime doesn't pass the compare (ABA)
+				uint32_t next = link(first - 1).load(std::memory_order_relaxed);
+				uint64_t new_head = (((head >> 32) + 1) << 32) | next;
+				if (m_free_head.compare_exchange_weak(head, new_head, std::memory_order_acq_rel, std::memory_order_acquire)) {
+					note_malloc(1);
+					return block(first - 1);
 				}
+				m_cas_retries.fetch_add(1, std::memory_order_relaxed);
 			}
+		}
+
+		// NOTE: size adjacent blocks from the first run page with room for them, a new run page
+		// is added when none has. Freed one by one or all at once with free(ptr, size).
+		T* malloc(int size) {
+			if (size <= 0 || size > m_page_blocks)
+				return nullptr;
+
+			std::lock_guard<std::mutex> lock(m_run_mutex);
 
-			if (consecutive_blocks_found == size) {
-				*pointer_to_edit = *((T**) end_block);
-				return start_block;
+			int npages = m_npages.load(std::memory_order_acquire);
+			for (int i = 0; i < npages; ++i) {
+				Page &p = m_pages[i];
+				if (!p.occupied || p.free_blocks < size)
+					continue;
+
+				int first = pool_find_clear_run(p.occupied, m_page_blocks, size);
+				if (first >= 0)
+					return take_run(p, first, size);
 			}
-			else
+
+			int page = add_page(true);
+			if (page < 0)
 				return nullptr;
+			return take_run(m_pages[page], 0, size);
 		}
 
 		void free(T *ptr) {
-			T** header = (T**) ptr;
-			*header = m_first_free_block;
-			m_first_free_block = ptr;
+			free(ptr, 1);
 		}
 
 		void free(T *ptr, int size) {
-			for (int i = size - 1; i >= 0; --i)
-				free(&ptr[i]);
+			uint32_t index = index_of(ptr);
+			Page &p = m_pages[index / m_page_blocks];
+
+			if (p.occupied) {
+				std::lock_guard<std::mutex> lock(m_run_mutex);
+				int first = index % m_page_blocks;
+				assert(first + size <= m_page_blocks);
+				pool_set_bits(p.occupied, first, size, false);
+				p.free_blocks += size;
+			}
+			else {
+				for (int i = size - 1; i >= 0; --i)
+					push(index + i);
+			}
+
+			note_free(size);
+		}
+
+		int capacity() const { return m_npages.load(std::memory_order_acquire) * m_page_blocks; }
+		int used() const { return m_used.load(std::memory_order_relaxed); }
+		int high_water() const { return m_high_water.load(std::memory_order_relaxed); }
+
+		Pool_stats stats() const {
+			Pool_stats s;
+			s.used = used();
+			s.high_water = high_water();
+			s.capacity = capacity();
+			s.pages = m_npages.load(std::memory_order_acquire);
+			s.run_pages = m_run_pages.load(std::memory_order_relaxed);
+			s.mallocs = m_mallocs.load(std::memory_order_relaxed);
+			s.frees = m_frees.load(std::memory_order_relaxed);
+			s.failed = m_failed.load(std::memory_order_relaxed);
+			s.cas_retries = m_cas_retries.load(std::memory_order_relaxed);
+			return s;
 		}
 
 	private:
-		T* m_memory;
-		const int m_size;
+		// NOTE: the free list links live next to the blocks rather than in them, so that a thread
+		// reading the link of a head another thread just popped doesn't read the other thread's T
+		struct Page
+		{
+			T *blocks;
+			std::atomic<uint32_t> *next; // NOTE: index + 1 of the next free block, 0 ends the list
+			uint64_t *occupied;          // NOTE: only run pages have it, guarded by m_run_mutex
+			int free_blocks;             // NOTE: run pages only
+		};
+
+		T* block(uint32_t index) {
+			return &m_pages[index / m_page_blocks].blocks[index % m_page_blocks];
+		}
+
+		std::atomic<uint32_t>& link(uint32_t index) {
+			return m_pages[index / m_page_blocks].next[index % m_page_blocks];
+		}
+
+		uint32_t index_of(T *ptr) {
+			int npages = m_npages.load(std::memory_order_acquire);
+			for (int i = 0; i < npages; ++i) {
+				T *blocks = m_pages[i].blocks;
+				if (ptr >= blocks && ptr < blocks + m_page_blocks)
+					return (uint32_t) (i * m_page_blocks + (ptr - blocks));
+			}
+
+			assert(!"pointer wasn't allocated from this pool");
+			return 0;
+		}
+
+		void push(uint32_t index) {
+			push_list(index, index);
+		}
+
+		// NOTE: pushes the blocks from first to last, which are already linked to each other
+		void push_list(uint32_t first, uint32_t last) {
+			uint64_t head = m_free_head.load(std::memory_order_relaxed);
+			for (;;) {
+				link(last).store((uint32_t) head, std::memory_order_relaxed);
+				uint64_t new_head = (((head >> 32) + 1) << 32) | (first + 1);
+				if (m_free_head.compare_exchange_weak(head, new_head, std::memory_order_release, std::memory_order_relaxed))
+					return;
+				m_cas_retries.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		// NOTE: adds a page and puts its blocks on the free list, nothing to do if another thread
+		// has refilled the free list in the meantime
+		bool grow() {
+			std::lock_guard<std::mutex> lock(m_grow_mutex);
+
+			if ((uint32_t) m_free_head.load(std::memory_order_acquire) != 0)
+				return true;
+
+			int page = add_page_locked(false);
+			if (page < 0)
+				return false;
+
+			Page &p = m_pages[page];
+			uint32_t first = (uint32_t) page * m_page_blocks;
+			uint32_t last = first + m_page_blocks - 1;
+			for (uint32_t i = first; i < last; ++i)
+				p.next[i - first].store(i + 2, std::memory_order_relaxed);
+			push_list(first, last);
+
+			return true;
+		}
+
+		int add_page(bool run_page) {
+			std::lock_guard<std::mutex> lock(m_grow_mutex);
+			return add_page_locked(run_page);
+		}
+
+		// NOTE: -1 when there is no room for another page
+		int add_page_locked(bool run_page) {
+			int page = m_npages.load(std::memory_order_relaxed);
+			if (page == m_max_pages) {
+				m_failed.fetch_add(1, std::memory_order_relaxed);
+				return -1;
+			}
+
+			int words = (m_page_blocks + 63) / 64;
+			Page &p = m_pages[page];
+			p.blocks = (T*) ::malloc(sizeof(T) * m_page_blocks);
+			if (run_page)
+				p.occupied = (uint64_t*) calloc(words, sizeof(uint64_t));
+			else
+				p.next = (std::atomic<uint32_t>*) calloc(m_page_blocks, sizeof(std::atomic<uint32_t>));
+			if (!p.blocks || (run_page ? !p.occupied : !p.next)) {
+				::free(p.blocks);
+				::free(p.next);
+				::free(p.occupied);
+				p = {};
+				m_failed.fetch_add(1, std::memory_order_relaxed);
+				return -1;
+			}
+
+			if (run_page) {
+				// NOTE: the bits past the last block are never free, so runs stop at the end of the page
+				pool_set_bits(p.occupied, m_page_blocks, words * 64 - m_page_blocks, true);
+				p.free_blocks = m_page_blocks;
+				m_run_pages.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			m_npages.store(page + 1, std::memory_order_release);
+			return page;
+		}
+
+		// NOTE: expects m_run_mutex to be held
+		T* take_run(Page &p, int first, int size) {
+			pool_set_bits(p.occupied, first, size, true);
+			p.free_blocks -= size;
+			note_malloc(size);
+			return &p.blocks[first];
+		}
+
+		void note_malloc(int n) {
+			m_mallocs.fetch_add(n, std::memory_order_relaxed);
+			int used = m_used.fetch_add(n, std::memory_order_relaxed) + n;
+			int high = m_high_water.load(std::memory_order_relaxed);
+			while (used > high && !m_high_water.compare_exchange_weak(high, used, std::memory_order_relaxed)) {}
+		}
+
+		void note_free(int n) {
+			m_frees.fetch_add(n, std::memory_order_relaxed);
+			m_used.fetch_sub(n, std::memory_order_relaxed);
+		}
+
+		const int m_page_blocks;
+		const int m_max_pages;
+
+		Page *m_pages;                   // NOTE: max_pages entries, the first m_npages are allocated
+		std::atomic<int> m_npages;
+		std::atomic<int> m_run_pages;
+		std::mutex m_grow_mutex;
+		std::mutex m_run_mutex;
+
+		std::atomic<uint64_t> m_free_head; // NOTE: tag in the upper 32 bits, index + 1 of the first free block in the lower
 
-		T* m_first_free_block;
+		std::atomic<int> m_used;
+		std::atomic<int> m_high_water;
+		std::atomic<int64_t> m_mallocs;
+		std::atomic<int64_t> m_frees;
+		std::atomic<int64_t> m_failed;
+		std::atomic<int64_t> m_cas_retries;
 };
@@ -0,0 +1,115 @@
+#include "Profiler.h"
+#include <chrono>
+#include "FlightRecorder.h"
+
+Profiler global_profiler = { {}, 0, -1, 0, {}, {}, {}, 0.0, 0.0 };
+
+const char *profiler_counter_names[PROFILER_COUNTER_COUNT] = {
+	"chunks_generated",
+	"chunks_rebuilt",
+	"draw_calls",
+	"vertices",
+	"uploads",
+	"bytes_uploaded",
+	"vao_binds",
+	"program_binds",
+	"texture_binds",
+	"uniforms",
+	"allocations",
+	"allocated_bytes",
+};
+
+const char *profiler_gauge_names[PROFILER_GAUGE_COUNT] = {
+	"live_vaos",
+	"live_buffers",
+	"chunk_mesh_bytes",
+};
+
+double profiler_now_ms() {
+	using namespace std::chrono;
+	return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+int profiler_enter(const char *name) {
+	Profiler &p = global_profiler;
+
+	int zone = -1;
+	for (int i = 0; i < p.nzones; ++i) {
+		if (p.zones[i].name == name && p.zones[i].parent == p.current) {
+			zone = i;
+			break;
+		}
+	}
+
+	if (zone < 0) {
+		// NOTE: zones past the limit are not recorded, their children end up under the enclosing zone
+		if (p.nzones == PROFILER_MAX_ZONES)
+			return -1;
+
+		zone = p.nzones++;
+		Profiler_zone &z = p.zones[zone];
+		z = {};
+		z.name = name;
+		z.parent = p.current;
+		z.depth = (p.current >= 0) ? p.zones[p.current].depth + 1 : 0;
+	}
+
+	p.current = zone;
+	return zone;
+}
+
+void profiler_exit(int zone, double ms) {
+	Profiler &p = global_profiler;
+	if (zone < 0)
+		return;
+
+	p.zones[zone].frame_ms += ms;
+	p.current = p.zones[zone].parent;
+}
+
+void profiler_end_frame() {
+	Profiler &p = global_profiler;
+	int slot = p.frame % PROFILER_HISTORY;
+	int frames = (p.frame + 1 < PROFILER_HISTORY) ? p.frame + 1 : PROFILER_HISTORY;
+
+	double now = profiler_now_ms();
+	p.last_frame_ms = (p.frame > 0) ? now - p.frame_start_ms : 0.0;
+	p.frame_start_ms = now;
+
+	// NOTE: the recorder needs the zone times before they are cleared
+	flight_recorder_end_frame(p);
+
+	for (int i = 0; i < p.nzones; ++i) {
+		Profiler_zone &z = p.zones[i];
+		z.history[slot] = z.frame_ms;
+		z.frame_ms = 0.0;
+		z.last_allocations = z.allocations;
+		z.last_allocated_bytes = z.allocated_bytes;
+		z.allocations = 0;
+		z.allocated_bytes = 0;
+
+		double sum = 0.0;
+		z.max_ms = 0.0;
+		for (int j = 0; j < PROFILER_HISTORY; ++j) {
+			sum += z.history[j];
+			if (z.history[j] > z.max_ms)
+				z.max_ms = z.history[j];
+		}
+		z.avg_ms = sum / frames;
+	}
+
+	// NOTE: counter tracks of the trace, one sample per frame
+	if (trace_capturing()) {
+		for (int i = 0; i < PROFILER_COUNTER_COUNT; ++i)
+			trace_counter(profiler_counter_names[i], p.counters[i]);
+		for (int i = 0; i < PROFILER_GAUGE_COUNT; ++i)
+			trace_counter(profiler_gauge_names[i], p.gauges[i]);
+	}
+
+	for (int i = 0; i < PROFILER_COUNTER_COUNT; ++i) {
+		p.last_counters[i] = p.counters[i];
+		p.counters[i] = 0;
+	}
+
+	p.frame++;
+}
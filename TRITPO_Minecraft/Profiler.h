@@ -0,0 +1,126 @@
+#pragma once
+#include <stdint.h>
+#include "Trace.h"
+
+// NOTE: set to 0 to compile every PROFILE_* macro out
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+#define PROFILER_MAX_ZONES 64
+#define PROFILER_HISTORY 64 // NOTE: frames the averages and maxima are taken over
+
+// NOTE: one node of the zone tree, the same name under another parent is another zone
+struct Profiler_zone
+{
+	const char *name; // NOTE: compared by pointer, has to be a string literal
+	int parent;       // NOTE: -1 for root zones
+	int depth;
+
+	double frame_ms;  // NOTE: sum over every time the zone was entered this frame
+	double history[PROFILER_HISTORY];
+	double avg_ms;
+	double max_ms;
+
+	// NOTE: heap allocations made directly in the zone, see AllocTracker.h
+	int64_t allocations;
+	int64_t allocated_bytes;
+	int64_t last_allocations;
+	int64_t last_allocated_bytes;
+};
+
+enum Profiler_counter
+{
+	PROFILER_COUNTER_CHUNKS_GENERATED,
+	PROFILER_COUNTER_CHUNKS_REBUILT,
+	PROFILER_COUNTER_DRAW_CALLS,
+	PROFILER_COUNTER_VERTICES,
+	PROFILER_COUNTER_UPLOADS,
+	PROFILER_COUNTER_BYTES_UPLOADED,
+	PROFILER_COUNTER_VAO_BINDS,
+	PROFILER_COUNTER_PROGRAM_BINDS,
+	PROFILER_COUNTER_TEXTURE_BINDS,
+	PROFILER_COUNTER_UNIFORMS,
+	PROFILER_COUNTER_ALLOCATIONS,
+	PROFILER_COUNTER_ALLOCATED_BYTES,
+
+	PROFILER_COUNTER_COUNT,
+};
+
+// NOTE: running totals, unlike counters they are not reset every frame
+enum Profiler_gauge
+{
+	PROFILER_GAUGE_LIVE_VAOS,
+	PROFILER_GAUGE_LIVE_BUFFERS,
+	PROFILER_GAUGE_CHUNK_MESH_BYTES, // NOTE: estimated from the sizes given to glBufferData
+
+	PROFILER_GAUGE_COUNT,
+};
+
+extern const char *profiler_counter_names[PROFILER_COUNTER_COUNT];
+extern const char *profiler_gauge_names[PROFILER_GAUGE_COUNT];
+
+struct Profiler
+{
+	Profiler_zone zones[PROFILER_MAX_ZONES];
+	int nzones;
+	int current; // NOTE: innermost open zone, -1 outside of every zone
+	int frame;
+
+	int64_t counters[PROFILER_COUNTER_COUNT];      // NOTE: main thread only, like the zones
+	int64_t last_counters[PROFILER_COUNTER_COUNT]; // NOTE: totals of the last finished frame
+	int64_t gauges[PROFILER_GAUGE_COUNT];
+
+	double frame_start_ms;
+	double last_frame_ms; // NOTE: wall time between the last two profiler_end_frame calls
+};
+
+extern Profiler global_profiler;
+
+double profiler_now_ms();
+int profiler_enter(const char *name);
+void profiler_exit(int zone, double ms);
+void profiler_end_frame();
+
+inline void profiler_count(Profiler_counter counter, int64_t n) {
+	global_profiler.counters[counter] += n;
+}
+
+inline void profiler_gauge_add(Profiler_gauge gauge, int64_t n) {
+	global_profiler.gauges[gauge] += n;
+}
+
+// NOTE: main thread only, the zone also goes into the trace while one is captured
+class Profile_scope {
+	public:
+		explicit Profile_scope(const char *name) : m_name(name), m_zone(profiler_enter(name)), m_start(profiler_now_ms()) {}
+		~Profile_scope() {
+			double end = profiler_now_ms();
+			profiler_exit(m_zone, end - m_start);
+			if (trace_capturing())
+				trace_complete(m_name, m_start, end);
+		}
+
+	private:
+		const char *m_name;
+		int m_zone;
+		double m_start;
+};
+
+#if PROFILER_ENABLED
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) Profile_scope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#define PROFILE_END_FRAME() profiler_end_frame()
+#define TRACE_SCOPE(name) Trace_scope PROFILE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_INSTANT(name, x, y, z) do { if (trace_capturing()) trace_instant(name, x, y, z); } while (0)
+#define PROFILE_COUNT(counter, n) profiler_count(counter, n)
+#define PROFILE_GAUGE_ADD(gauge, n) profiler_gauge_add(gauge, n)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_END_FRAME()
+#define TRACE_SCOPE(name)
+#define TRACE_INSTANT(name, x, y, z) do {} while (0)
+#define PROFILE_COUNT(counter, n) do {} while (0)
+#define PROFILE_GAUGE_ADD(gauge, n) do {} while (0)
+#endif
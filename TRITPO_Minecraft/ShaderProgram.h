@@ -15,10 +15,10 @@ class ShaderProgram {
 		void use();
 		GLuint get();
 
-		void set1f(std::string name, float value);
-		void set3fv(std::string name, const glm::vec3 &vector);
-		void setMatrix4fv(std::string name, const glm::mat4 &matrix);
-		void setMatrix4fv(std::string name, float *matrix);
+		void set1f(const char *name, float value);
+		void set3fv(const char *name, const glm::vec3 &vector);
+		void setMatrix4fv(const char *name, const glm::mat4 &matrix);
+		void setMatrix4fv(const char *name, float *matrix);
 
 	private:
 		GLuint m_shaderProgram;
@@ -3,7 +3,7 @@
 #define GLFW_INCLUDE_GLU
 #include <GLFW/glfw3.h>
 
-ShadowMap::ShadowMap(unsigned int width, unsigned int height) : m_width(width), m_height(height) {
+ShadowMap::ShadowMap(unsigned int width, unsigned int height, bool compare) : m_width(width), m_height(height) {
 	glGenFramebuffers(1, &m_depthMapFBO);
 
 	glGenTextures(1, &m_depthMap);
@@ -15,6 +15,10 @@ ShadowMap::ShadowMap(unsigned int width, unsigned int height) : m_width(width),
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
 	float borderColor[] = { 1.0f, 0.0f, 0.0f, 0.0f };
 	glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+	if (compare) {
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	}
 
 	glBindFramebuffer(GL_FRAMEBUFFER, m_depthMapFBO);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depthMap, 0);
@@ -36,6 +40,18 @@ void ShadowMap::unbind() {
 	glViewport(oldViewportDims[0], oldViewportDims[1], oldViewportDims[2], oldViewportDims[3]);
 }
 
+void ShadowMap::resize(unsigned int width, unsigned int height) {
+	if (width == m_width && height == m_height)
+		return;
+
+	m_width = width;
+	m_height = height;
+
+	glBindTexture(GL_TEXTURE_2D, m_depthMap);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
 unsigned int ShadowMap::get() {
 	return m_depthMap;
 }
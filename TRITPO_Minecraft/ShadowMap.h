@@ -3,10 +3,12 @@
 
 class ShadowMap {
 	public:
-		ShadowMap(unsigned int width, unsigned int height);
+		// NOTE: compare maps are sampled with sampler2DShadow, the hardware filters 2x2 depth comparisons per lookup
+		ShadowMap(unsigned int width, unsigned int height, bool compare = false);
 
 		void bind();
 		void unbind();
+		void resize(unsigned int width, unsigned int height);
 		unsigned int get();
 
 	private:
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+
+#define WORLD_SEED 0x7b447dc7
+#define TERRAIN_HEIGHT_SCALE 16 // NOTE: height of one chunk
+
+float perlin_noise(float x, float z);
+int get_height(int x, int z);
+
+// NOTE: fills terrain into a dim^3 block array that is already cleared to BLOCK_AIR,
+// returns the number of solid blocks written. min_height and max_height, when given,
+// get the lowest and highest surface height of the chunk's column.
+int generate_chunk_blocks(uint8_t *blocks, int dim, int chunk_x, int chunk_y, int chunk_z,
+                          int *min_height = nullptr, int *max_height = nullptr);
@@ -0,0 +1,129 @@
+#include "Trace.h"
+#include <stdio.h>
+#include <thread>
+#include "Profiler.h"
+
+Trace global_trace;
+
+static std::atomic<int> next_tid(0);
+
+static int trace_tid() {
+	static thread_local int tid = next_tid.fetch_add(1);
+	return tid;
+}
+
+static Trace_event *trace_record(const char *name, Trace_event_type type, double start_ms, double dur_us) {
+	Trace &t = global_trace;
+
+	// NOTE: the caller fills in the rest of the event and then calls trace_record_done
+	t.writers.fetch_add(1);
+	if (t.capturing.load()) {
+		int idx = t.nevents.fetch_add(1);
+		if (idx < TRACE_MAX_EVENTS) {
+			Trace_event &e = t.events[idx];
+			e = {};
+			e.name = name;
+			e.type = type;
+			e.ts_us = (start_ms - t.start_ms) * 1000.0;
+			e.dur_us = dur_us;
+			e.tid = trace_tid();
+			return &e;
+		}
+	}
+
+	return nullptr;
+}
+
+static void trace_record_done() {
+	global_trace.writers.fetch_sub(1);
+}
+
+void trace_start() {
+	Trace &t = global_trace;
+	if (t.capturing.load())
+		return;
+
+	if (!t.events)
+		t.events = new Trace_event[TRACE_MAX_EVENTS];
+
+	t.nevents.store(0);
+	t.start_ms = profiler_now_ms();
+	t.capturing.store(true);
+}
+
+bool trace_stop() {
+	Trace &t = global_trace;
+	if (!t.capturing.load())
+		return true;
+
+	// NOTE: wait for the threads that are still writing an event
+	t.capturing.store(false);
+	while (t.writers.load())
+		std::this_thread::yield();
+
+	int nevents = t.nevents.load();
+	if (nevents > TRACE_MAX_EVENTS)
+		nevents = TRACE_MAX_EVENTS;
+
+	char path[64];
+	snprintf(path, sizeof(path), "trace_%d.json", t.ncaptures++);
+	FILE *f = fopen(path, "w");
+	if (!f)
+		return false;
+
+	fprintf(f, "{\"traceEvents\":[\n");
+	for (int i = 0; i < nevents; ++i) {
+		const Trace_event &e = t.events[i];
+		const char *separator = (i + 1 < nevents) ? "," : "";
+
+		switch (e.type) {
+			case TRACE_EVENT_COMPLETE:
+				fprintf(f, "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}%s\n",
+					e.name, e.ts_us, e.dur_us, e.tid, separator);
+				break;
+			case TRACE_EVENT_INSTANT:
+				fprintf(f, "{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{\"x\":%d,\"y\":%d,\"z\":%d}}%s\n",
+					e.name, e.ts_us, e.tid, e.x, e.y, e.z, separator);
+				break;
+			case TRACE_EVENT_COUNTER:
+				fprintf(f, "{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{\"value\":%lld}}%s\n",
+					e.name, e.ts_us, (long long) e.value, separator);
+				break;
+		}
+	}
+	fprintf(f, "],\"otherData\":{\"dropped_events\":%d}}\n", t.nevents.load() - nevents);
+	fclose(f);
+
+	printf("Trace written to %s\n", path);
+	return true;
+}
+
+void trace_complete(const char *name, double start_ms, double end_ms) {
+	trace_record(name, TRACE_EVENT_COMPLETE, start_ms, (end_ms - start_ms) * 1000.0);
+	trace_record_done();
+}
+
+void trace_instant(const char *name, int x, int y, int z) {
+	Trace_event *e = trace_record(name, TRACE_EVENT_INSTANT, profiler_now_ms(), 0.0);
+	if (e) {
+		e->x = x;
+		e->y = y;
+		e->z = z;
+	}
+	trace_record_done();
+}
+
+void trace_counter(const char *name, int64_t value) {
+	Trace_event *e = trace_record(name, TRACE_EVENT_COUNTER, profiler_now_ms(), 0.0);
+	if (e)
+		e->value = value;
+	trace_record_done();
+}
+
+Trace_scope::Trace_scope(const char *name) : m_name(name), m_start(profiler_now_ms()) {
+}
+
+Trace_scope::~Trace_scope() {
+	if (trace_capturing())
+		trace_complete(m_name, m_start, profiler_now_ms());
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+#define TRACE_MAX_EVENTS (1 << 18) // NOTE: events past this are dropped until the capture is restarted
+
+// NOTE: capture of timed scopes and instant events in the Chrome Trace Event format,
+// viewable in chrome://tracing or Perfetto. Events can be recorded from any thread.
+enum Trace_event_type
+{
+	TRACE_EVENT_COMPLETE,
+	TRACE_EVENT_INSTANT,
+	TRACE_EVENT_COUNTER,
+};
+
+struct Trace_event
+{
+	const char *name; // NOTE: not copied, has to be a string literal
+	Trace_event_type type;
+	double ts_us;
+	double dur_us;
+	int tid;
+	int x, y, z;      // NOTE: chunk coordinates of instant events
+	int64_t value;    // NOTE: value of counter events
+};
+
+struct Trace
+{
+	std::atomic<bool> capturing;
+	std::atomic<int> writers;
+	std::atomic<int> nevents;
+	Trace_event *events;
+	double start_ms;
+	int ncaptures;
+};
+
+extern Trace global_trace;
+
+void trace_start();
+// NOTE: writes the capture to trace_<n>.json, returns false when the file could not be written
+bool trace_stop();
+
+void trace_complete(const char *name, double start_ms, double end_ms);
+void trace_instant(const char *name, int x, int y, int z);
+void trace_counter(const char *name, int64_t value);
+
+inline bool trace_capturing() {
+	return global_trace.capturing.load(std::memory_order_relaxed);
+}
+
+// NOTE: times a scope for the trace only, unlike PROFILE_SCOPE it is safe off the main thread
+class Trace_scope {
+	public:
+		explicit Trace_scope(const char *name);
+		~Trace_scope();
+
+	private:
+		const char *m_name;
+		double m_start;
+};
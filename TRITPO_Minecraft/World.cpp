@@ -3,6 +3,10 @@
 #include "assert.h"
 #include "WorldGeneration.hpp"
 
+static uint64_t chunk_key(int x, int y, int z) {
+	return ((uint64_t)(x & 0x1FFFFF) << 42) | ((uint64_t)(y & 0x1FFFFF) << 21) | (uint64_t)(z & 0x1FFFFF);
+}
+
 Chunk* World::add_chunk(int x, int y, int z) {
 	Chunk *result = allocator->malloc();
 
@@ -13,6 +17,17 @@ Chunk* World::add_chunk(int x, int y, int z) {
         result->z = z;
 		result->changed = false;
 		result->render = true;
+		result->occluded = false;
+		result->query_pending = false;
+		result->occlusion_query = 0;
+		result->unreachable = false;
+		result->connectivity = ALL_FACES_CONNECTED;
+		result->below_horizon = false;
+		result->surface_min = 0;
+		result->surface_max = 0;
+		result->view_dist = 0.0f;
+		result->edit_cache = -1;
+		result->lod = 0;
         result->nblocks = 0;
 		
         for (int i = 0; i < BLOCKS_IN_CHUNK; i++)
@@ -22,12 +37,12 @@ Chunk* World::add_chunk(int x, int y, int z) {
 
         for (int i = 0; i < BLOCK_TYPE_COUNT; i++)
         {
-            result->meshes[i].num_of_vs = 0;
-            result->meshes[i].vao = 0;
-            result->meshes[i].vbo = 0;
+            result->meshes[i] = {};
         }
+        result->shadow_mesh = {};
 
 		visible_chunks.push_back(result);
+		chunk_map[chunk_key(x, y, z)] = result;
     }
 
     return (result);
@@ -40,16 +55,21 @@ void World::load_chunk(int x, int y, int z) {
 		if (c->x == x && c->y == y && c->z == z) {
 			unloaded_chunks.erase(unloaded_chunks.begin() + i);
 			visible_chunks.push_back(c);
+			chunk_map[chunk_key(x, y, z)] = c;
 			push_chunk_for_rebuild(c);
+			TRACE_INSTANT("load", x, y, z);
 			return;
 		}
 	}
 
 	generate_chunk(*this, x, y, z);
+	TRACE_INSTANT("generate", x, y, z);
 }
 
 void World::unload_chunk(int chunk_id) {
 	Chunk *c = visible_chunks[chunk_id];
+	chunk_map.erase(chunk_key(c->x, c->y, c->z));
+	TRACE_INSTANT("unload", c->x, c->y, c->z);
 
 	if (!c->changed) {
 		c->free_mesh();
@@ -60,6 +80,8 @@ void World::unload_chunk(int chunk_id) {
 		c->free_mesh();
 		visible_chunks.erase(visible_chunks.begin() + chunk_id);
 		unloaded_chunks.push_back(c);
+		if (unloaded_chunks.size() > unloaded_high_water)
+			unloaded_high_water = unloaded_chunks.size();
 	}
 }
 
@@ -71,6 +93,17 @@ Chunk* World::pop_chunk_for_rebuild() {
 	assert(!rebuild_stack.empty());
 	Chunk *c = rebuild_stack.top();
 	rebuild_stack.pop();
+	TRACE_INSTANT("rebuild", c->x, c->y, c->z);
 
     return c;
 }
+
+void World::push_block_edit(Chunk *c, int block_idx) {
+	block_edits.push_back({ c, block_idx });
+}
+
+Chunk* World::find_chunk(int x, int y, int z) {
+	auto it = chunk_map.find(chunk_key(x, y, z));
+
+	return (it != chunk_map.end()) ? it->second : nullptr;
+}
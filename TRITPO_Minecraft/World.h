@@ -2,11 +2,17 @@
 
 #include <vector>
 #include <stack>
+#include <unordered_map>
 #include "Chunk.h"
 #include "PoolAllocator.hpp"
 
 class Game_state;
 
+struct Block_edit {
+	Chunk *chunk;
+	int block_idx;
+};
+
 class World {
 	public:
 		Chunk* add_chunk(int x, int y, int z);
@@ -14,10 +20,15 @@ class World {
 		void unload_chunk(int chunk_id);
 		void push_chunk_for_rebuild(Chunk *c);
 		Chunk* pop_chunk_for_rebuild();
+		void push_block_edit(Chunk *c, int block_idx);
+		Chunk* find_chunk(int x, int y, int z);
 
 		std::vector<Chunk*> visible_chunks;
 		std::vector<Chunk*> unloaded_chunks;
+		size_t unloaded_high_water; // NOTE: changed chunks are never freed, so this only grows with edits
 		std::stack<Chunk*> rebuild_stack;
+		std::vector<Block_edit> block_edits;
+		std::unordered_map<uint64_t, Chunk*> chunk_map; // NOTE: visible chunks by position
 
 		PoolAllocator<Chunk> *allocator;
 };
\ No newline at end of file
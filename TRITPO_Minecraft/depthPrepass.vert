@@ -0,0 +1,13 @@
+#version 330 core
+
+layout (location = 0) in vec3 aVertexPos;
+
+uniform mat4 u_projection;
+uniform mat4 u_view;
+uniform mat4 u_model;
+
+invariant gl_Position; // NOTE: has to match mesh.vert for GL_EQUAL depth
+
+void main() {
+	gl_Position = u_projection * u_view * u_model * vec4(aVertexPos, 1.0f);
+}
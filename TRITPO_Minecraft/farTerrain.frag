@@ -0,0 +1,37 @@
+#version 330 core
+
+uniform vec3 u_color;
+uniform vec3 u_camera_pos;
+uniform float u_fade_start;
+uniform float u_fade_end;
+
+in vec3 normal;
+in vec3 world_pos;
+
+out vec4 frag_color;
+
+uniform vec3 light_pos;
+uniform float ambient_factor;
+uniform float diffuse_strength;
+
+const float bayer[16] = float[16](
+	 0.0 / 16.0,  8.0 / 16.0,  2.0 / 16.0, 10.0 / 16.0,
+	12.0 / 16.0,  4.0 / 16.0, 14.0 / 16.0,  6.0 / 16.0,
+	 3.0 / 16.0, 11.0 / 16.0,  1.0 / 16.0,  9.0 / 16.0,
+	15.0 / 16.0,  7.0 / 16.0, 13.0 / 16.0,  5.0 / 16.0
+);
+
+void main() {
+	// NOTE: the near edge dissolves with an ordered dither, chunks are drawn over it anyway
+	vec2 d = abs(world_pos.xz - u_camera_pos.xz);
+	float fade = clamp((max(d.x, d.y) - u_fade_start) / (u_fade_end - u_fade_start), 0.0f, 1.0f);
+	ivec2 p = ivec2(gl_FragCoord.xy) & 3;
+	if (fade <= bayer[p.y * 4 + p.x])
+		discard;
+
+	vec3 light_col = vec3(1, 1, 1);
+	float diffuse_factor = clamp(dot(normalize(normal), normalize(light_pos)), 0.0f, 1.0f);
+	vec3 light = light_col * clamp(ambient_factor + diffuse_factor * diffuse_strength, 0.0f, 1.0f);
+
+	frag_color = vec4(u_color * light, 1.0f);
+}
@@ -5,11 +5,12 @@ layout (location = 1) in vec3 aVertexNormal;
 
 uniform mat4 u_projection;
 uniform mat4 u_view;
-uniform mat4 u_model;
 
 out vec3 normal;
+out vec3 world_pos;
 
 void main() {
-   gl_Position = u_model * u_projection * u_view * vec4(aVertexPos, 1.0f);
-   normal = aVertexNormal;
-}
\ No newline at end of file
+	gl_Position = u_projection * u_view * vec4(aVertexPos, 1.0f);
+	normal = aVertexNormal;
+	world_pos = aVertexPos;
+}
@@ -0,0 +1,31 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 texCoords;
+in vec4 vertexColor;
+flat in int texIdx;
+
+uniform sampler2D fontTex;
+uniform sampler2D inventoryBarTex;
+uniform sampler2D crossTex;
+uniform sampler2D layerTex;
+
+void main() {
+	// NOTE: texture indices follow Hud_texture, every sampler is read so that the lookups stay in uniform control flow
+	vec4 font = texture(fontTex, texCoords);
+	vec4 inventoryBar = texture(inventoryBarTex, texCoords);
+	vec4 cross = texture(crossTex, texCoords);
+	vec4 layer = texture(layerTex, texCoords);
+
+	vec4 color = vec4(1.0f);
+	if (texIdx == 1)
+		color = vec4(font.rgb, max(font.r, max(font.g, font.b))); // NOTE: white glyphs on black, black is transparent
+	else if (texIdx == 2)
+		color = inventoryBar;
+	else if (texIdx == 3)
+		color = cross;
+	else if (texIdx == 4)
+		color = layer;
+
+	FragColor = color * vertexColor;
+}
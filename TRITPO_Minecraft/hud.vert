@@ -0,0 +1,16 @@
+#version 330 core
+layout (location = 0) in vec2 pos;
+layout (location = 1) in vec2 uv;
+layout (location = 2) in vec4 color;
+layout (location = 3) in float textureIdx;
+
+out vec2 texCoords;
+out vec4 vertexColor;
+flat out int texIdx;
+
+void main() {
+	texCoords = uv;
+	vertexColor = color;
+	texIdx = int(textureIdx + 0.5);
+	gl_Position = vec4(pos, 0.0f, 1.0f);
+}
@@ -1,5 +1,8 @@
 #include <stdio.h> // sprintf
+#include <string.h> // strcmp
+#include <stdlib.h> // atof
 #include <assert.h>
+#include <climits>
 #include <iostream>
 #include <algorithm>
 #include <stack>
@@ -98,21 +101,19 @@ Raycast_result raycast(World *world, Vec3f pos, Vec3f view_dir)
         int chunk_y = j >> CHUNK_DIM_LOG2;
         int chunk_z = k >> CHUNK_DIM_LOG2;
         
-        for (Chunk *c : world->visible_chunks)
+        Chunk *c = world->find_chunk(chunk_x, chunk_y, chunk_z);
+        if (c)
         {
-            if ((chunk_x == c->x) && (chunk_y == c->y) && (chunk_z == c->z))
-            {
-                int mask = ~((~1) << (CHUNK_DIM_LOG2 - 1));
-                int block_x = i & mask;
-                int block_y = j & mask;
-                int block_z = k & mask;
+            int mask = ~((~1) << (CHUNK_DIM_LOG2 - 1));
+            int block_x = i & mask;
+            int block_y = j & mask;
+            int block_z = k & mask;
 
-                if (c->blocks[CHUNK_DIM * CHUNK_DIM * block_y + CHUNK_DIM * block_z + block_x] != BLOCK_AIR)
-                {
-                    chunk = c;
-                    collision = true;
-                    goto end_loop;
-                }
+            if (c->blocks[CHUNK_DIM * CHUNK_DIM * block_y + CHUNK_DIM * block_z + block_x] != BLOCK_AIR)
+            {
+                chunk = c;
+                collision = true;
+                goto end_loop;
             }
         }
 
@@ -172,134 +173,68 @@ end_loop:
     return (result);
 }
 
-void gen_ranges_3d(uint8_t *blocks, Range3d *ranges, uint8_t *visited, int dim, int count, int *num_of_ranges)
-{
-    int ranges_count = 0;
-
-    while (count > 0)
-    {
-        int start_z = 0;
-        int end_z = 0;
-
-        int start_y = 0;
-        int end_y = 0;
-
-        int start_x = 0;
-        int end_x = 0;
-
-        // skip all visited and empty blocks
-        for (start_y = 0; start_y < dim; start_y++)
-        {
-            for (start_z = 0; start_z < dim; start_z++)
-            {
-                for (start_x = 0; start_x < dim; start_x++)
-                {
-                    if (visited[start_y * dim * dim + start_z * dim + start_x] == 0 &&
-                        blocks[start_y * dim * dim + start_z * dim + start_x] != BLOCK_AIR)
-                    {
-                        goto break1;
-                    }
-                }
-            }
-        }
-    break1:
-
-        // If a block at (start_x, start_y, start_z) is in the grid (the grid is not empty), mark it as visited.
-        // Also record block type.
-        uint8_t block_type = BLOCK_AIR;
-        if (start_x < dim && start_y < dim && start_z < dim)
-        {
-            visited[start_y * dim * dim + start_z * dim + start_x] = 1;
-            block_type = blocks[start_y * dim * dim + start_z * dim + start_x];
-            count--;
-        }
-
-        // try expand in x direction
-        end_x = start_x;
-        while ((end_x + 1 < dim) &&
-            (blocks[start_y * dim * dim + start_z * dim + (end_x + 1)] == block_type) &&
-            (visited[start_y * dim * dim + start_z * dim + (end_x + 1)] == 0))
-        {
-            visited[start_y * dim * dim + start_z * dim + (end_x + 1)] = 1;
-            end_x++;
-            count--;
-        }
-
-        // try expand in z direction
-        end_z = start_z;
-        while (end_z + 1 < dim)
-        {
-            bool can_expand = true;
-            for (int x = start_x; x <= end_x; x++)
-            {
-                if (blocks[start_y * dim * dim + (end_z + 1) * dim + x] != block_type ||
-                    visited[start_y * dim * dim + (end_z + 1) * dim + x] == 1)
-                {
-                    can_expand = false;
-                    break;
-                }
-            }
-
-            if (can_expand)
-            {
-                // mark expanded row of block as visited
-                for (int x = start_x; x <= end_x; x++)
-                {
-                    visited[start_y * dim * dim + (end_z + 1) * dim + x] = 1;
-                }
-                end_z++;
-                count -= end_x - start_x + 1;
-            }
-            else
-            {
-                break;
-            }
-        }
-
-        // try expand in y direction
-        end_y = start_y;
-        while (end_y + 1 < dim)
-        {
-            bool can_expand = true;
-            for (int z = start_z; z <= end_z; z++)
-            {
-                for (int x = start_x; x <= end_x; x++)
-                {
-                    if (blocks[(end_y + 1) * dim * dim + z * dim + x] != block_type ||
-                        visited[(end_y + 1) * dim * dim + z * dim + x] == 1)
-                    {
-                        can_expand = false;
-                        goto break2;
-                    }
-                }
-            }
-        break2:
-            if (can_expand)
-            {
-                for (int z = start_z; z <= end_z; z++)
-                {
-                    for (int x = start_x; x <= end_x; x++)
-                    {
-                        visited[(end_y + 1) * dim * dim + z * dim + x] = 1;
-                    }
-                }
-                end_y++;
-                count -= (end_x - start_x + 1) * (end_z - start_z + 1);
-            }
-            else
-            {
-                break;
-            }
-        }
+static const Shadow_quality shadow_qualities[SHADOW_QUALITY_COUNT] = {
+	{ "Low",    1024, 2, 1 },
+	{ "Medium", 1024, 3, 4 },
+	{ "High",   2048, 4, 4 },
+	{ "Ultra",  2048, 4, 9 },
+};
 
-        assert(block_type != BLOCK_AIR);
-        ranges[ranges_count++] = { block_type, start_x, start_y, start_z, end_x, end_y, end_z };
-    }
+void apply_shadow_quality(Game_state *state) {
+	const Shadow_quality &quality = shadow_qualities[state->shadowQuality];
 
-    assert(count == 0);
-    *num_of_ranges = ranges_count;
+	state->shadowMap1.resize(quality.resolution, quality.resolution);
+	state->shadowMap2.resize(quality.resolution, quality.resolution);
+	state->shadowMap3.resize(quality.resolution, quality.resolution);
+	state->shadowMap4.resize(quality.resolution, quality.resolution);
 }
 
+// NOTE: position and normal, for the cube VAO and the inventory blocks of the HUD
+static const float cubeVertices[] = {
+    // positions          
+    -1.0f,  1.0f, -1.0f,	 0.0f,  0.0f, -1.0f,
+    -1.0f, -1.0f, -1.0f,	 0.0f,  0.0f, -1.0f,
+     1.0f, -1.0f, -1.0f,	 0.0f,  0.0f, -1.0f,
+     1.0f, -1.0f, -1.0f,	 0.0f,  0.0f, -1.0f,
+     1.0f,  1.0f, -1.0f,	 0.0f,  0.0f, -1.0f,
+    -1.0f,  1.0f, -1.0f,	 0.0f,  0.0f, -1.0f,
+
+    -1.0f, -1.0f,  1.0f,	-1.0f,  0.0f,  0.0f,
+    -1.0f, -1.0f, -1.0f,	-1.0f,  0.0f,  0.0f,
+    -1.0f,  1.0f, -1.0f,	-1.0f,  0.0f,  0.0f,
+    -1.0f,  1.0f, -1.0f,	-1.0f,  0.0f,  0.0f,
+    -1.0f,  1.0f,  1.0f,	-1.0f,  0.0f,  0.0f,
+    -1.0f, -1.0f,  1.0f,	-1.0f,  0.0f,  0.0f,
+
+     1.0f, -1.0f, -1.0f,	 1.0f,  0.0f,  0.0f,
+     1.0f, -1.0f,  1.0f,	 1.0f,  0.0f,  0.0f,
+     1.0f,  1.0f,  1.0f,	 1.0f,  0.0f,  0.0f,
+     1.0f,  1.0f,  1.0f,	 1.0f,  0.0f,  0.0f,
+     1.0f,  1.0f, -1.0f,	 1.0f,  0.0f,  0.0f,
+     1.0f, -1.0f, -1.0f,	 1.0f,  0.0f,  0.0f,
+
+    -1.0f, -1.0f,  1.0f,	 0.0f,  0.0f,  1.0f,
+    -1.0f,  1.0f,  1.0f,	 0.0f,  0.0f,  1.0f,
+     1.0f,  1.0f,  1.0f,	 0.0f,  0.0f,  1.0f,
+     1.0f,  1.0f,  1.0f,	 0.0f,  0.0f,  1.0f,
+     1.0f, -1.0f,  1.0f,	 0.0f,  0.0f,  1.0f,
+    -1.0f, -1.0f,  1.0f,	 0.0f,  0.0f,  1.0f,
+
+    -1.0f,  1.0f, -1.0f,	 0.0f,  1.0f,  0.0f,
+     1.0f,  1.0f, -1.0f,	 0.0f,  1.0f,  0.0f,
+     1.0f,  1.0f,  1.0f,	 0.0f,  1.0f,  0.0f,
+     1.0f,  1.0f,  1.0f,	 0.0f,  1.0f,  0.0f,
+    -1.0f,  1.0f,  1.0f,	 0.0f,  1.0f,  0.0f,
+    -1.0f,  1.0f, -1.0f,	 0.0f,  1.0f,  0.0f,
+
+    -1.0f, -1.0f, -1.0f,	 0.0f, -1.0f,  0.0f,
+    -1.0f, -1.0f,  1.0f,	 0.0f, -1.0f,  0.0f,
+     1.0f, -1.0f, -1.0f,	 0.0f, -1.0f,  0.0f,
+     1.0f, -1.0f, -1.0f,	 0.0f, -1.0f,  0.0f,
+    -1.0f, -1.0f,  1.0f,	 0.0f, -1.0f,  0.0f,
+     1.0f, -1.0f,  1.0f, 	 0.0f, -1.0f,  0.0f
+};
+
 void game_state_and_memory_init(Game_memory *memory)
 {
     assert(!memory->is_initialized);
@@ -308,51 +243,6 @@ void game_state_and_memory_init(Game_memory *memory)
 
     memory->is_initialized = 1;
 
-    float cubeVertices[] = {
-        // positions          
-        -1.0f,  1.0f, -1.0f,	 0.0f,  0.0f, -1.0f,
-        -1.0f, -1.0f, -1.0f,	 0.0f,  0.0f, -1.0f,
-         1.0f, -1.0f, -1.0f,	 0.0f,  0.0f, -1.0f,
-         1.0f, -1.0f, -1.0f,	 0.0f,  0.0f, -1.0f,
-         1.0f,  1.0f, -1.0f,	 0.0f,  0.0f, -1.0f,
-        -1.0f,  1.0f, -1.0f,	 0.0f,  0.0f, -1.0f,
-
-        -1.0f, -1.0f,  1.0f,	-1.0f,  0.0f,  0.0f,
-        -1.0f, -1.0f, -1.0f,	-1.0f,  0.0f,  0.0f,
-        -1.0f,  1.0f, -1.0f,	-1.0f,  0.0f,  0.0f,
-        -1.0f,  1.0f, -1.0f,	-1.0f,  0.0f,  0.0f,
-        -1.0f,  1.0f,  1.0f,	-1.0f,  0.0f,  0.0f,
-        -1.0f, -1.0f,  1.0f,	-1.0f,  0.0f,  0.0f,
-
-         1.0f, -1.0f, -1.0f,	 1.0f,  0.0f,  0.0f,
-         1.0f, -1.0f,  1.0f,	 1.0f,  0.0f,  0.0f,
-         1.0f,  1.0f,  1.0f,	 1.0f,  0.0f,  0.0f,
-         1.0f,  1.0f,  1.0f,	 1.0f,  0.0f,  0.0f,
-         1.0f,  1.0f, -1.0f,	 1.0f,  0.0f,  0.0f,
-         1.0f, -1.0f, -1.0f,	 1.0f,  0.0f,  0.0f,
-
-        -1.0f, -1.0f,  1.0f,	 0.0f,  0.0f,  1.0f,
-        -1.0f,  1.0f,  1.0f,	 0.0f,  0.0f,  1.0f,
-         1.0f,  1.0f,  1.0f,	 0.0f,  0.0f,  1.0f,
-         1.0f,  1.0f,  1.0f,	 0.0f,  0.0f,  1.0f,
-         1.0f, -1.0f,  1.0f,	 0.0f,  0.0f,  1.0f,
-        -1.0f, -1.0f,  1.0f,	 0.0f,  0.0f,  1.0f,
-
-        -1.0f,  1.0f, -1.0f,	 0.0f,  1.0f,  0.0f,
-         1.0f,  1.0f, -1.0f,	 0.0f,  1.0f,  0.0f,
-         1.0f,  1.0f,  1.0f,	 0.0f,  1.0f,  0.0f,
-         1.0f,  1.0f,  1.0f,	 0.0f,  1.0f,  0.0f,
-        -1.0f,  1.0f,  1.0f,	 0.0f,  1.0f,  0.0f,
-        -1.0f,  1.0f, -1.0f,	 0.0f,  1.0f,  0.0f,
-
-        -1.0f, -1.0f, -1.0f,	 0.0f, -1.0f,  0.0f,
-        -1.0f, -1.0f,  1.0f,	 0.0f, -1.0f,  0.0f,
-         1.0f, -1.0f, -1.0f,	 0.0f, -1.0f,  0.0f,
-         1.0f, -1.0f, -1.0f,	 0.0f, -1.0f,  0.0f,
-        -1.0f, -1.0f,  1.0f,	 0.0f, -1.0f,  0.0f,
-         1.0f, -1.0f,  1.0f, 	 0.0f, -1.0f,  0.0f
-    };
-
 	float squareVertices[] = {
 		-1.0f,  1.0f,  0.0f,
         -1.0f, -1.0f,  0.0f,
@@ -368,6 +258,17 @@ void game_state_and_memory_init(Game_memory *memory)
 	new (&state->world.rebuild_stack) std::stack<Chunk*>();
 	new (&state->world.visible_chunks) std::vector<Chunk*>();
 	new (&state->world.unloaded_chunks) std::vector<Chunk*>();
+	new (&state->world.block_edits) std::vector<Block_edit>();
+	new (&state->world.chunk_map) std::unordered_map<uint64_t, Chunk*>();
+
+	for (int i = 0; i < EDIT_CACHE_SIZE; i++)
+	{
+		state->edit_caches[i].chunk = nullptr;
+		state->edit_caches[i].nranges = 0;
+		state->edit_caches[i].last_used = 0;
+		state->edit_caches[i].shadow_dirty = false;
+		state->edit_caches[i].shadow_built = 0;
+	}
 
     state->cam_pos = Vec3f(0, 120, 0);
     state->cam_up = Vec3f(0, 1, 0);
@@ -385,30 +286,53 @@ void game_state_and_memory_init(Game_memory *memory)
     state->cam_move_dir.z = state->cam_view_dir.z;
 
     state->block_to_place = BLOCK_GRASS;
+	state->depthPrepass = false;
+	state->heightmapShadows = true;
+	state->shadowQuality = SHADOW_QUALITY_DEFAULT;
+	state->profilerOverlay = false;
+	state->memoryDumps = 0;
 
 	state->frameCount = 0;
 	state->fpsCounterPrevTime = glfwGetTime();
 	state->fps = 0;
+	state->hudFps = -1;
+	state->hudBlockToPlace = -1;
+	state->hudShadowQuality = -1;
 
     // NOTE(max): call constructors on existing memory
     new (&state->mesh_sp) ShaderProgram("mesh");
     new (&state->skyboxSP) ShaderProgram("skybox");
 	new (&state->sunSP) ShaderProgram("sun");
-	new (&state->imageSP) ShaderProgram("image");
-	new (&state->inventoryBlockSP) ShaderProgram("inventoryBlock");
 	new (&state->meshShadowMapSP) ShaderProgram("meshShadowMap");
-	new (&state->fontCharacterSP) ShaderProgram("fontchar");
-	new (&state->shadowMap1) ShadowMap(2048, 2048);
-	new (&state->shadowMap2) ShadowMap(2048, 2048);
-	new (&state->shadowMap3) ShadowMap(2048, 2048);
-	new (&state->shadowMap4) ShadowMap(2048, 2048);
+	new (&state->hudSP) ShaderProgram("hud");
+	new (&state->farTerrainSP) ShaderProgram("farTerrain");
+	new (&state->depthPrepassSP) ShaderProgram("depthPrepass");
+	new (&state->farTerrain) FarTerrain();
+	new (&state->hud) HudBatch();
+	new (&state->hudLayer) HudLayer();
+	new (&state->heightmapShadow) HeightmapShadow();
+	new (&state->shadowMap1) ShadowMap(shadow_qualities[state->shadowQuality].resolution, shadow_qualities[state->shadowQuality].resolution, true);
+	new (&state->shadowMap2) ShadowMap(shadow_qualities[state->shadowQuality].resolution, shadow_qualities[state->shadowQuality].resolution, true);
+	new (&state->shadowMap3) ShadowMap(shadow_qualities[state->shadowQuality].resolution, shadow_qualities[state->shadowQuality].resolution, true);
+	new (&state->shadowMap4) ShadowMap(shadow_qualities[state->shadowQuality].resolution, shadow_qualities[state->shadowQuality].resolution, true);
 	new (&state->sunTexture) Texture("Images/sun.png", GL_RGBA);
 	new (&state->inventoryBarTexture) Texture("Images/inventoryBar.png");
 	new (&state->crossTexture) Texture("Images/cross.png");
 	new (&state->fontTexture) Texture("Images/OpenSans.bmp");
     new (&state->skybox) Skybox("Images/cubemap");
 
-    // Cube VAO (Skybox, inventory blocks)
+	state->fontTexture.bind();
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	state->hudSP.use();
+	glUniform1i(glGetUniformLocation(state->hudSP.get(), "fontTex"), 0);
+	glUniform1i(glGetUniformLocation(state->hudSP.get(), "inventoryBarTex"), 1);
+	glUniform1i(glGetUniformLocation(state->hudSP.get(), "crossTex"), 2);
+	glUniform1i(glGetUniformLocation(state->hudSP.get(), "layerTex"), 3);
+
+    // Cube VAO (Skybox, occlusion query boxes)
     glGenVertexArrays(1, &state->cubeVAO);
     glGenBuffers(1, &state->cubeVBO);
     glBindVertexArray(state->cubeVAO);
@@ -431,10 +355,101 @@ void game_state_and_memory_init(Game_memory *memory)
     glBindVertexArray(0);
 }
 
-void renderWorld(Game_state *state, ShaderProgram &sp) {
+static_assert(SCRATCH_ARENA_COUNT <= 32, "scratch arena slots are bits of a uint32_t");
+
+// NOTE: bit i is set while a thread holds scratch arena i
+static std::atomic<uint32_t> scratch_slots_taken(0);
+
+// NOTE: gives the slot back when its thread ends
+struct Scratch_slot
+{
+	int index = -1;
+
+	~Scratch_slot() {
+		if (index >= 0)
+			scratch_slots_taken.fetch_and(~(1u << index));
+	}
+};
+
+// NOTE: every thread gets the scratch arena of the slot it takes on its first call and keeps it
+// until it ends. More threads than SCRATCH_ARENA_COUNT at once report it and abort, like an arena overflow.
+Memory_arena *scratch_arena(Game_memory *memory) {
+	static thread_local Scratch_slot slot;
+
+	if (slot.index < 0)
+	{
+		uint32_t taken = scratch_slots_taken.load();
+		for (;;)
+		{
+			int index = 0;
+			while (index < SCRATCH_ARENA_COUNT && (taken & (1u << index)))
+				index++;
+
+			if (index == SCRATCH_ARENA_COUNT)
+			{
+				fprintf(stderr, "No scratch arena left, more than %d threads are holding one\n", SCRATCH_ARENA_COUNT);
+				abort();
+			}
+
+			if (scratch_slots_taken.compare_exchange_weak(taken, taken | (1u << index)))
+			{
+				slot.index = index;
+				// NOTE: whatever the last thread in the slot left behind is garbage now
+				arena_reset(&memory->scratch_arenas[index]);
+				break;
+			}
+		}
+	}
+
+	return &memory->scratch_arenas[slot.index];
+}
+
+void renderShadowCasters(Game_state *state, ShaderProgram &sp) {
+	for (Chunk *c : state->world.visible_chunks)
+	{
+		Mesh *mesh = &c->shadow_mesh;
+		if (mesh->num_of_vs)
+		{
+			Vec3f chunk_offset(
+				(float)(c->x * CHUNK_DIM),
+				(float)(c->y * CHUNK_DIM),
+				(float)(c->z * CHUNK_DIM));
+
+			Mat4x4f model = mat4x4f_identity();
+			model = mat4x4f_translate(model, chunk_offset);
+			sp.setMatrix4fv("u_model", &model.m[0][0]);
+
+			glBindVertexArray(mesh->vao);
+			glDrawArrays(GL_TRIANGLES, 0, mesh->num_of_vs);
+		}
+	}
+
+	glBindVertexArray(0);
+}
+
+// NOTE: face directions of a chunk that can face the camera, both directions of an axis
+// when the camera is inside the chunk's slab along it
+uint8_t chunk_facing_faces(Chunk *c, Vec3f cam_pos) {
+	float x0 = (float)(c->x * CHUNK_DIM);
+	float y0 = (float)(c->y * CHUNK_DIM);
+	float z0 = (float)(c->z * CHUNK_DIM);
+
+	uint8_t faces = 0;
+	if (cam_pos.y < y0 + CHUNK_DIM) faces |= 1 << FACE_BOTTOM;
+	if (cam_pos.y > y0)             faces |= 1 << FACE_TOP;
+	if (cam_pos.z < z0 + CHUNK_DIM) faces |= 1 << FACE_NORTH;
+	if (cam_pos.z > z0)             faces |= 1 << FACE_SOUTH;
+	if (cam_pos.x < x0 + CHUNK_DIM) faces |= 1 << FACE_WEST;
+	if (cam_pos.x > x0)             faces |= 1 << FACE_EAST;
+
+	return (faces);
+}
+
+// NOTE: camera_culling skips the chunks the culling stages hid from the camera, shadow passes draw them all
+void renderWorld(Game_state *state, ShaderProgram &sp, bool camera_culling = false) {
 	for (Chunk *c : state->world.visible_chunks)
 	{
-		if (c->nblocks && c->render)
+		if (c->nblocks && c->render && !(camera_culling && (c->occluded || c->unreachable || c->below_horizon)))
 		{
 			Vec3f chunk_offset(
 				(float)(c->x * CHUNK_DIM),
@@ -445,15 +460,41 @@ void renderWorld(Game_state *state, ShaderProgram &sp) {
 			model = mat4x4f_translate(model, chunk_offset);
 			sp.setMatrix4fv("u_model", &model.m[0][0]);
 
+			uint8_t faces = camera_culling ? chunk_facing_faces(c, state->cam_pos) : ALL_FACES;
+
 			for (int m_idx = 0; m_idx < BLOCK_TYPE_COUNT; m_idx++)
 			{
 				Mesh *mesh = &c->meshes[m_idx];
 				if (mesh->num_of_vs)
 				{
+					// NOTE: one draw per run of adjacent face groups
+					GLint firsts[FACE_COUNT];
+					GLsizei counts[FACE_COUNT];
+					int ndraws = 0;
+					for (int f = 0; f < FACE_COUNT; f++)
+					{
+						if (!(faces & (1 << f)) || mesh->face_vs[f] == 0)
+							continue;
+
+						if (ndraws > 0 && firsts[ndraws - 1] + counts[ndraws - 1] == mesh->face_first[f])
+						{
+							counts[ndraws - 1] += mesh->face_vs[f];
+						}
+						else
+						{
+							firsts[ndraws] = mesh->face_first[f];
+							counts[ndraws] = mesh->face_vs[f];
+							ndraws++;
+						}
+					}
+
+					if (ndraws == 0)
+						continue;
+
 					Vec3f mesh_color = Block_colors[m_idx];
 					glUniform3f(glGetUniformLocation(sp.get(), "u_color"), mesh_color.r, mesh_color.g, mesh_color.b);
 					glBindVertexArray(mesh->vao);
-					glDrawArrays(GL_TRIANGLES, 0, mesh->num_of_vs);
+					glMultiDrawArrays(GL_TRIANGLES, firsts, counts, ndraws);
 					glBindVertexArray(0);
 				}
 			}
@@ -461,288 +502,1047 @@ void renderWorld(Game_state *state, ShaderProgram &sp) {
 	}
 }
 
-void drawText(Game_state *state, Game_input *input, std::string text, float x, float y, float scale) {
-	const float spacing = 0.6;
+struct Cave_cull_step
+{
+	Chunk *chunk;
+	int entry_face; // NOTE: -1 for the camera chunk
+	uint8_t dirs;   // NOTE: directions walked to get here
+};
+
+// NOTE: breadth first search from the camera chunk, a chunk is reachable when the face it was entered
+// through is connected by air to the face it is left through. The search never walks against a direction
+// it already took and only goes through chunks that passed frustum culling, so buried chunks stay unreachable.
+void cave_culling(Game_memory *memory, glm::vec3 cameraPos) {
+	static const int face_offsets[FACE_COUNT][3] = {
+		{ 0, -1, 0 }, { 0, 1, 0 }, { 0, 0, -1 }, { 0, 0, 1 }, { -1, 0, 0 }, { 1, 0, 0 }
+	};
+
+	World &world = memory->game_state->world;
+	Chunk *cam_chunk = world.find_chunk(
+		(int) floorf(cameraPos.x) >> CHUNK_DIM_LOG2,
+		(int) floorf(cameraPos.y) >> CHUNK_DIM_LOG2,
+		(int) floorf(cameraPos.z) >> CHUNK_DIM_LOG2);
+
+	for (Chunk *c : world.visible_chunks) {
+		c->unreachable = (cam_chunk != nullptr);
+	}
+
+	if (!cam_chunk)
+		return;
+
+	// NOTE: every chunk is queued at most once
+	Cave_cull_step *queue = ARENA_PUSH_ARRAY(&memory->frame_arena, Cave_cull_step, world.visible_chunks.size());
+	int head = 0;
+	int tail = 0;
+
+	queue[tail++] = { cam_chunk, -1, 0 };
+	cam_chunk->unreachable = false;
+
+	while (head < tail)
+	{
+		Cave_cull_step step = queue[head++];
+
+		for (int f = 0; f < FACE_COUNT; f++)
+		{
+			int opposite = f ^ 1;
+			if (step.dirs & (1 << opposite))
+				continue;
+
+			if (step.entry_face >= 0 && !(step.chunk->connectivity & FACE_PAIR_BIT(step.entry_face, f)))
+				continue;
+
+			Chunk *n = world.find_chunk(
+				step.chunk->x + face_offsets[f][0],
+				step.chunk->y + face_offsets[f][1],
+				step.chunk->z + face_offsets[f][2]);
+			if (!n || !n->unreachable || !n->render)
+				continue;
+
+			n->unreachable = false;
+			queue[tail++] = { n, opposite, (uint8_t)(step.dirs | (1 << f)) };
+		}
+	}
+}
+
+// NOTE: slope of a point seen from the camera, dist is the horizontal distance to it
+float horizon_slope(float dy, float dist) {
+	if (dist <= 0.0f)
+		return (dy > 0.0f) ? INFINITY : -INFINITY;
+
+	return (dy / dist);
+}
+
+// NOTE: horizon bins covered by a column, x0..x1 and z0..z1 relative to the camera
+void horizon_column_bins(float x0, float x1, float z0, float z1, int *first_bin, int *last_bin) {
+	float center = atan2f((z0 + z1) / 2, (x0 + x1) / 2);
+	float corners_x[4] = { x0, x1, x0, x1 };
+	float corners_z[4] = { z0, z0, z1, z1 };
+
+	float min_delta = 0.0f;
+	float max_delta = 0.0f;
+	for (int i = 0; i < 4; i++)
+	{
+		float delta = atan2f(corners_z[i], corners_x[i]) - center;
+		if (delta > PI) delta -= 2 * PI;
+		if (delta < -PI) delta += 2 * PI;
+
+		min_delta = std::min(min_delta, delta);
+		max_delta = std::max(max_delta, delta);
+	}
+
+	float bins_per_radian = HORIZON_BINS / (2 * PI);
+	*first_bin = (int) floorf((center + min_delta + PI) * bins_per_radian);
+	*last_bin = (int) floorf((center + max_delta + PI) * bins_per_radian);
+}
+
+// NOTE: walks the chunk columns around the camera ring by ring, front to back, keeping the highest
+// slope the terrain covers in every direction. A chunk whose top is below that slope over all of its
+// directions is hidden by closer columns. A column occludes up to the lowest generated surface height
+// in it, it doesn't occlude at all once one of its chunks is edited or one below the surface is missing.
+void horizon_culling(Game_state *state, glm::vec3 cameraPos) {
+	float horizon[HORIZON_BINS];
+	float ring_horizon[HORIZON_BINS];
+
+	for (int b = 0; b < HORIZON_BINS; b++)
+		horizon[b] = -INFINITY;
+
+	for (Chunk *c : state->world.visible_chunks)
+		c->below_horizon = false;
+
+	int cam_chunk_x = (int) floorf(cameraPos.x) >> CHUNK_DIM_LOG2;
+	int cam_chunk_y = (int) floorf(cameraPos.y) >> CHUNK_DIM_LOG2;
+	int cam_chunk_z = (int) floorf(cameraPos.z) >> CHUNK_DIM_LOG2;
+
+	for (int ring = 0; ring <= WORLD_RADIUS; ring++)
+	{
+		for (int b = 0; b < HORIZON_BINS; b++)
+			ring_horizon[b] = INFINITY;
+
+		for (int dz = -ring; dz <= ring; dz++)
+		{
+			for (int dx = -ring; dx <= ring; dx++)
+			{
+				if (std::max(abs(dx), abs(dz)) != ring)
+					continue;
+
+				int cx = cam_chunk_x + dx;
+				int cz = cam_chunk_z + dz;
+
+				float x0 = cx * CHUNK_DIM - cameraPos.x;
+				float x1 = x0 + CHUNK_DIM;
+				float z0 = cz * CHUNK_DIM - cameraPos.z;
+				float z1 = z0 + CHUNK_DIM;
+
+				float near_x = (x0 > 0) ? x0 : ((x1 < 0) ? -x1 : 0.0f);
+				float near_z = (z0 > 0) ? z0 : ((z1 < 0) ? -z1 : 0.0f);
+				float far_x = std::max(fabsf(x0), fabsf(x1));
+				float far_z = std::max(fabsf(z0), fabsf(z1));
+				float near_dist = sqrtf(near_x * near_x + near_z * near_z);
+				float far_dist = sqrtf(far_x * far_x + far_z * far_z);
+
+				int first_bin = 0;
+				int last_bin = HORIZON_BINS - 1;
+				if (ring > 0)
+					horizon_column_bins(x0, x1, z0, z1, &first_bin, &last_bin);
+
+				Chunk *column[2 * GENERATION_Y_RADIUS + 1];
+				int surface_min = INT_MAX;
+				for (int i = 0; i < 2 * GENERATION_Y_RADIUS + 1; i++)
+				{
+					column[i] = state->world.find_chunk(cx, cam_chunk_y - GENERATION_Y_RADIUS + i, cz);
+					if (column[i] && !column[i]->changed)
+						surface_min = std::min(surface_min, column[i]->surface_min);
+				}
+
+				bool occluder = (surface_min != INT_MAX);
+				for (int i = 0; i < 2 * GENERATION_Y_RADIUS + 1; i++)
+				{
+					Chunk *c = column[i];
+					int chunk_bottom = (cam_chunk_y - GENERATION_Y_RADIUS + i) * CHUNK_DIM;
+					if ((!c || c->changed) && chunk_bottom < surface_min)
+						occluder = false;
+
+					if (!c)
+						continue;
+
+					c->below_horizon = false;
+					if (ring <= 1 || !c->nblocks)
+						continue;
+
+					float top = (float) (chunk_bottom + CHUNK_DIM);
+					if (!c->changed)
+						top = std::min(top, (float) c->surface_max);
+
+					float dy = top - cameraPos.y;
+					float slope = horizon_slope(dy, (dy > 0) ? near_dist : far_dist);
+
+					bool hidden = true;
+					for (int b = first_bin; b <= last_bin; b++)
+					{
+						if (slope >= horizon[(b + HORIZON_BINS) % HORIZON_BINS])
+						{
+							hidden = false;
+							break;
+						}
+					}
+					c->below_horizon = hidden;
+				}
 
-	glEnable(GL_COLOR_LOGIC_OP);
-	glLogicOp(GL_OR);
+				// NOTE: rays above the camera leave the column before far_dist, rays below it enter it after near_dist
+				float occluder_slope = -INFINITY;
+				if (occluder)
+				{
+					float dy = surface_min - cameraPos.y;
+					occluder_slope = horizon_slope(dy, (dy > 0) ? far_dist : near_dist);
+				}
+
+				for (int b = first_bin; b <= last_bin; b++)
+				{
+					float &h = ring_horizon[(b + HORIZON_BINS) % HORIZON_BINS];
+					h = std::min(h, occluder_slope);
+				}
+			}
+		}
+
+		// NOTE: every ray leaves a ring before entering the next one, so a ring only occludes the rings after it
+		for (int b = 0; b < HORIZON_BINS; b++)
+		{
+			if (ring_horizon[b] != INFINITY)
+				horizon[b] = std::max(horizon[b], ring_horizon[b]);
+		}
+	}
+}
 
+// NOTE: insertion sort by distance to the camera, the order barely changes between frames so this stays close to O(n)
+void sort_chunks_front_to_back(Game_state *state, glm::vec3 cameraPos) {
+	auto &chunks = state->world.visible_chunks;
+
+	for (Chunk *c : chunks) {
+		glm::vec3 d = glm::vec3(c->x * CHUNK_DIM + CHUNK_DIM / 2, c->y * CHUNK_DIM + CHUNK_DIM / 2, c->z * CHUNK_DIM + CHUNK_DIM / 2) - cameraPos;
+		c->view_dist = glm::dot(d, d);
+	}
+
+	for (size_t i = 1; i < chunks.size(); i++) {
+		Chunk *c = chunks[i];
+		size_t j = i;
+		while (j > 0 && chunks[j - 1]->view_dist > c->view_dist) {
+			chunks[j] = chunks[j - 1];
+			j--;
+		}
+		chunks[j] = c;
+	}
+}
+
+// NOTE: picks up the occlusion queries issued in earlier frames. Queries that aren't
+// done yet keep the last result, so the CPU never waits for the GPU here.
+void read_occlusion_queries(Game_state *state) {
+	for (Chunk *c : state->world.visible_chunks)
+	{
+		if (!c->query_pending)
+			continue;
+
+		GLuint available = 0;
+		glGetQueryObjectuiv(c->occlusion_query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available)
+		{
+			GLuint any_samples_passed = 0;
+			glGetQueryObjectuiv(c->occlusion_query, GL_QUERY_RESULT, &any_samples_passed);
+			c->occluded = !any_samples_passed;
+			c->query_pending = false;
+		}
+	}
+}
+
+// NOTE: tests the bounding boxes of the chunks in the frustum against the depth of this frame,
+// the results decide what gets drawn in the next frames. Expects mesh_sp with the camera matrices.
+void issue_occlusion_queries(Game_state *state) {
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_FALSE);
+	glDisable(GL_STENCIL_TEST);
 	glDisable(GL_CULL_FACE);
+	glBindVertexArray(state->cubeVAO);
+
+	for (Chunk *c : state->world.visible_chunks)
+	{
+		// NOTE: chunks coming back into the frustum are drawn until a new query says otherwise
+		if (!c->render)
+			c->occluded = false;
+
+		if (!c->nblocks || !c->render || c->unreachable || c->below_horizon || c->query_pending)
+			continue;
+
+		glm::vec3 center(c->x * CHUNK_DIM + CHUNK_DIM / 2, c->y * CHUNK_DIM + CHUNK_DIM / 2, c->z * CHUNK_DIM + CHUNK_DIM / 2);
+		float half_size = CHUNK_DIM / 2 + OCCLUSION_BOX_MARGIN;
+
+		// NOTE: the box would be clipped by the near plane, the chunk is visible anyway
+		glm::vec3 d = glm::abs(glm::vec3(state->cam_pos.x, state->cam_pos.y, state->cam_pos.z) - center);
+		if (d.x < half_size + 1.0f && d.y < half_size + 1.0f && d.z < half_size + 1.0f)
+		{
+			c->occluded = false;
+			continue;
+		}
+
+		if (c->occlusion_query == 0)
+			glGenQueries(1, &c->occlusion_query);
+
+		glm::mat4 model(1);
+		model = glm::translate(model, center);
+		model = glm::scale(model, glm::vec3(half_size, half_size, half_size));
+		state->mesh_sp.setMatrix4fv("u_model", model);
+
+		glBeginQuery(GL_ANY_SAMPLES_PASSED, c->occlusion_query);
+		glDrawArrays(GL_TRIANGLES, 0, 36);
+		glEndQuery(GL_ANY_SAMPLES_PASSED);
+		c->query_pending = true;
+	}
+
+	glBindVertexArray(0);
+	glEnable(GL_CULL_FACE);
+	glEnable(GL_STENCIL_TEST);
+	glDepthMask(GL_TRUE);
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+void drawText(Game_state *state, Game_input *input, const char *text, float x, float y, float scale) {
+	const float spacing = 0.6;
+
+	for (int i = 0; text[i]; ++i) {
+		int pos = toupper(text[i]) - 32;
+
+		glm::vec2 center(x + spacing * i * scale * 2 / input->aspect_ratio, y);
+		glm::vec2 size(scale / input->aspect_ratio, scale);
+		glm::vec2 uv(pos % 8 / 8.0f, (7 - pos / 8) / 8.0f);
+		state->hud.quad(center - size, center + size, uv, uv + glm::vec2(1.0f / 8.0f), HUD_TEXTURE_FONT);
+	}
+}
+
+// NOTE: the lit faces of a cube facing the camera, projected on the CPU so that they go into the HUD batch
+void drawInventoryBlock(Game_state *state, const glm::mat4 &transform, Vec3f color) {
+	const glm::vec3 lightDir = glm::normalize(glm::vec3(0.5f, 0.8f, 1.0f));
+
+	for (int t = 0; t < 36; t += 3) {
+		glm::vec2 p[3];
+		for (int k = 0; k < 3; ++k) {
+			const float *v = &cubeVertices[(t + k) * 6];
+			glm::vec4 clip = transform * glm::vec4(v[0], v[1], v[2], 1.0f);
+			p[k] = glm::vec2(clip) / clip.w;
+		}
+
+		float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[2].x - p[0].x) * (p[1].y - p[0].y);
+		if (area >= 0.0f)
+			continue;
+
+		const float *n = &cubeVertices[t * 6 + 3];
+		float light = glm::clamp(0.3f + std::max(0.0f, glm::dot(glm::vec3(n[0], n[1], n[2]), lightDir)), 0.0f, 1.0f);
+		state->hud.triangle(p[0], p[1], p[2], glm::vec4(color.r * light, color.g * light, color.b * light, 1.0f));
+	}
+}
+
+// NOTE: zone tree with the average and the maximum over the last PROFILER_HISTORY frames
+void drawProfilerZones(Game_state *state, Game_memory *memory, Game_input *input, int parent, float *y) {
+	const Profiler &profiler = global_profiler;
+
+	for (int i = 0; i < profiler.nzones; ++i) {
+		const Profiler_zone &zone = profiler.zones[i];
+		if (zone.parent != parent)
+			continue;
+
+		const char *line;
+#if ALLOC_TRACKING_ENABLED
+		line = arena_printf(&memory->frame_arena, "%*s%-*s %6.2f %6.2f %6lld", zone.depth * 2, "", 24 - zone.depth * 2, zone.name, zone.avg_ms, zone.max_ms, (long long) zone.last_allocations);
+#else
+		line = arena_printf(&memory->frame_arena, "%*s%-*s %6.2f %6.2f", zone.depth * 2, "", 24 - zone.depth * 2, zone.name, zone.avg_ms, zone.max_ms);
+#endif
+		drawText(state, input, line, -0.96f, *y, 0.025f);
+		*y -= 0.055f;
+
+		drawProfilerZones(state, memory, input, i, y);
+	}
+}
+
+struct Memory_report
+{
+	int meshes;          // NOTE: meshes that hold a vbo, shadow meshes included
+	int64_t mesh_bytes;
+	int64_t largest_mesh_bytes;
+};
+
+Memory_report gather_memory_report(Game_state *state) {
+	Memory_report report = {};
+
+	for (Chunk *c : state->world.visible_chunks) {
+		for (int i = 0; i <= BLOCK_TYPE_COUNT; ++i) {
+			const Mesh &m = (i < BLOCK_TYPE_COUNT) ? c->meshes[i] : c->shadow_mesh;
+			if (m.vao == 0)
+				continue;
+
+			report.meshes++;
+			report.mesh_bytes += m.buffer_bytes;
+			report.largest_mesh_bytes = std::max(report.largest_mesh_bytes, (int64_t) m.buffer_bytes);
+		}
+	}
+
+	return report;
+}
+
+// NOTE: totals followed by the GPU bytes of every mesh of every visible chunk, unloaded chunks hold no meshes
+bool dump_memory_report(Game_state *state, Game_memory *memory) {
+	char path[64];
+	snprintf(path, sizeof(path), "memory_%d.txt", state->memoryDumps);
+	FILE *f = fopen(path, "w");
+	if (!f)
+		return false;
+	state->memoryDumps++;
+
+	const PoolAllocator<Chunk> &pool = *state->chunkAllocator;
+	const World &world = state->world;
+	Memory_report report = gather_memory_report(state);
+
+	Pool_stats pool_stats = pool.stats();
+	fprintf(f, "chunk_pool_used %d\n", pool_stats.used);
+	fprintf(f, "chunk_pool_high_water %d\n", pool_stats.high_water);
+	fprintf(f, "chunk_pool_capacity %d\n", pool_stats.capacity);
+	fprintf(f, "chunk_pool_pages %d\n", pool_stats.pages);
+	fprintf(f, "chunk_pool_bytes %llu\n", (unsigned long long) pool_stats.capacity * sizeof(Chunk));
+	fprintf(f, "chunk_pool_mallocs %lld\n", (long long) pool_stats.mallocs);
+	fprintf(f, "chunk_pool_frees %lld\n", (long long) pool_stats.frees);
+	fprintf(f, "chunk_pool_failed %lld\n", (long long) pool_stats.failed);
+	fprintf(f, "chunk_pool_cas_retries %lld\n", (long long) pool_stats.cas_retries);
+	fprintf(f, "visible_chunks %zu\n", world.visible_chunks.size());
+	fprintf(f, "unloaded_chunks %zu\n", world.unloaded_chunks.size());
+	fprintf(f, "unloaded_chunks_high_water %zu\n", world.unloaded_high_water);
+	for (int i = 0; i <= SCRATCH_ARENA_COUNT; ++i) {
+		const Memory_arena &arena = (i == 0) ? memory->frame_arena : memory->scratch_arenas[i - 1];
+		fprintf(f, "arena_%d_%s_last_frame_bytes %llu\n", i, arena.name, (unsigned long long) arena.last_frame_high_water);
+		fprintf(f, "arena_%d_%s_high_water_bytes %llu\n", i, arena.name, (unsigned long long) arena.high_water);
+		fprintf(f, "arena_%d_%s_capacity_bytes %llu\n", i, arena.name, (unsigned long long) arena.size);
+	}
+	fprintf(f, "chunk_meshes %d\n", report.meshes);
+	fprintf(f, "chunk_mesh_bytes %lld\n", (long long) report.mesh_bytes);
+	fprintf(f, "largest_chunk_mesh_bytes %lld\n", (long long) report.largest_mesh_bytes);
+	for (int i = 0; i < PROFILER_GAUGE_COUNT; ++i)
+		fprintf(f, "%s %lld\n", profiler_gauge_names[i], (long long) global_profiler.gauges[i]);
+
+	fprintf(f, "\nx,y,z,lod");
+	for (int i = 0; i < BLOCK_TYPE_COUNT; ++i)
+		fprintf(f, ",mesh_%d_bytes", i);
+	fprintf(f, ",shadow_mesh_bytes\n");
+
+	for (Chunk *c : world.visible_chunks) {
+		fprintf(f, "%d,%d,%d,%d", c->x, c->y, c->z, c->lod);
+		for (int i = 0; i < BLOCK_TYPE_COUNT; ++i)
+			fprintf(f, ",%d", c->meshes[i].buffer_bytes);
+		fprintf(f, ",%d\n", c->shadow_mesh.buffer_bytes);
+	}
+
+	fclose(f);
+	std::cout << "Memory report written to " << path << std::endl;
+	return true;
+}
+
+void drawMemoryOverlay(Game_state *state, Game_memory *memory, Game_input *input, float x, float y) {
+	const PoolAllocator<Chunk> &pool = *state->chunkAllocator;
+	const World &world = state->world;
+	Memory_report report = gather_memory_report(state);
+
+	const char *line;
+	line = arena_printf(&memory->frame_arena, "%-20s %10s %10s", "Memory", "now", "peak");
+	drawText(state, input, line, x, y, 0.025f);
+	y -= 0.055f;
+
+	line = arena_printf(&memory->frame_arena, "%-20s %10d %10d", "chunk pool", pool.used(), pool.high_water());
+	drawText(state, input, line, x, y, 0.025f);
+	y -= 0.055f;
+
+	line = arena_printf(&memory->frame_arena, "%-20s %10zu %10zu", "unloaded chunks", world.unloaded_chunks.size(), world.unloaded_high_water);
+	drawText(state, input, line, x, y, 0.025f);
+	y -= 0.055f;
+
+	line = arena_printf(&memory->frame_arena, "%-20s %10llu %10llu", "frame arena KB",
+		(unsigned long long) memory->frame_arena.last_frame_high_water / 1024, (unsigned long long) memory->frame_arena.high_water / 1024);
+	drawText(state, input, line, x, y, 0.025f);
+	y -= 0.055f;
+
+	line = arena_printf(&memory->frame_arena, "%-20s %10llu %10llu", "scratch arena KB",
+		(unsigned long long) memory->scratch_arenas[0].last_frame_high_water / 1024, (unsigned long long) memory->scratch_arenas[0].high_water / 1024);
+	drawText(state, input, line, x, y, 0.025f);
+	y -= 0.055f;
+
+	line = arena_printf(&memory->frame_arena, "%-20s %10lld %10lld", "mesh KB, avg/max",
+		(long long) (report.meshes ? report.mesh_bytes / report.meshes : 0) / 1024, (long long) report.largest_mesh_bytes / 1024);
+	drawText(state, input, line, x, y, 0.025f);
+	y -= 0.055f;
+
+	line = arena_printf(&memory->frame_arena, "%-20s %10lld", "mesh KB, total", (long long) report.mesh_bytes / 1024);
+	drawText(state, input, line, x, y, 0.025f);
+}
+
+void drawProfilerOverlay(Game_state *state, Game_memory *memory, Game_input *input) {
+	float y = 0.82f;
+
+	const char *header;
+#if ALLOC_TRACKING_ENABLED
+	header = arena_printf(&memory->frame_arena, "%-24s %6s %6s %6s", "Zone, ms", "avg", "max", "allocs");
+#else
+	header = arena_printf(&memory->frame_arena, "%-24s %6s %6s", "Zone, ms", "avg", "max");
+#endif
+	drawText(state, input, header, -0.96f, y, 0.025f);
+	y -= 0.055f;
+
+	drawProfilerZones(state, memory, input, -1, &y);
+	y -= 0.055f;
+
+	const Gpu_profiler &gpu = global_gpu_profiler;
+	header = arena_printf(&memory->frame_arena, "%-24s %6s %6s", "GPU pass, ms", "avg", "max");
+	drawText(state, input, header, -0.96f, y, 0.025f);
+	y -= 0.055f;
+
+	for (int i = 0; i < gpu.npasses; ++i) {
+		const Gpu_pass &pass = gpu.passes[i];
+
+		const char *line;
+		line = arena_printf(&memory->frame_arena, "%-24s %6.2f %6.2f", pass.name, pass.avg_ms, pass.max_ms);
+		drawText(state, input, line, -0.96f, y, 0.025f);
+		y -= 0.055f;
+	}
+
+	if (gpu.csv) {
+		drawText(state, input, "Logging to " GPU_TIMINGS_CSV, -0.96f, y, 0.025f);
+	}
+
+	// NOTE: counters of the last finished frame and the live totals in a second column
+	y = 0.82f;
+	header = arena_printf(&memory->frame_arena, "%-20s %10s", "Counter", "frame");
+	drawText(state, input, header, 0.3f, y, 0.025f);
+	y -= 0.055f;
+
+	for (int i = 0; i < PROFILER_COUNTER_COUNT; ++i) {
+		const char *line;
+		line = arena_printf(&memory->frame_arena, "%-20s %10lld", profiler_counter_names[i], (long long) global_profiler.last_counters[i]);
+		drawText(state, input, line, 0.3f, y, 0.025f);
+		y -= 0.055f;
+	}
+	y -= 0.055f;
+
+	for (int i = 0; i < PROFILER_GAUGE_COUNT; ++i) {
+		const char *line;
+		line = arena_printf(&memory->frame_arena, "%-20s %10lld", profiler_gauge_names[i], (long long) global_profiler.gauges[i]);
+		drawText(state, input, line, 0.3f, y, 0.025f);
+		y -= 0.055f;
+	}
+	y -= 0.055f;
+
+	drawMemoryOverlay(state, memory, input, 0.3f, y);
+}
+
+// NOTE: while the layer itself is drawn into it can't be bound for sampling (feedback loop),
+// so unit 3 gets texture 0 then
+void flushHud(Game_state *state, bool bindLayer) {
+	state->hudSP.use();
 	glActiveTexture(GL_TEXTURE0);
-	glBindVertexArray(state->squareVAO);
 	state->fontTexture.bind();
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	state->fontCharacterSP.use();
+	glActiveTexture(GL_TEXTURE1);
+	state->inventoryBarTexture.bind();
+	glActiveTexture(GL_TEXTURE2);
+	state->crossTexture.bind();
+	glActiveTexture(GL_TEXTURE3);
+	glBindTexture(GL_TEXTURE_2D, bindLayer ? state->hudLayer.get() : 0);
+	glActiveTexture(GL_TEXTURE0);
 
-	for (int i = 0; i < text.size(); ++i) {
-		int pos = toupper(text[i]) - 32;
+	state->hud.flush();
+}
 
-		glm::mat4 model(1);
-		model = glm::translate(model, glm::vec3(x + spacing * i * scale * 2 / input->aspect_ratio, y, 0.0f));
-		model = glm::scale(model, glm::vec3(scale / input->aspect_ratio, scale, 1.0f));
-		state->fontCharacterSP.setMatrix4fv("model", model);
-		state->fontCharacterSP.set3fv("texturePos", glm::vec3(pos % 8, 7 - pos / 8, 0));
-		glDrawArrays(GL_TRIANGLES, 0, 6);
+static_assert(CHUNK_DIM == MASK_DIM, "gen_ranges_bitmask only meshes 16^3 chunks");
+
+Chunk_edit_cache *find_edit_cache(Game_state *state, Chunk *chunk) {
+	int idx = chunk->edit_cache;
+	if (idx >= 0 && idx < EDIT_CACHE_SIZE && state->edit_caches[idx].chunk == chunk)
+	{
+		state->edit_caches[idx].last_used = state->frameCount;
+		return &state->edit_caches[idx];
+	}
+
+	return nullptr;
+}
+
+void rebuild_shadow_mesh(Game_memory *memory, Chunk *chunk, const uint8_t *blocks, GLenum usage);
+
+Chunk_edit_cache *acquire_edit_cache(Game_memory *memory, Chunk *chunk) {
+	Game_state *state = memory->game_state;
+	Chunk_edit_cache *cache = find_edit_cache(state, chunk);
+	if (cache)
+		return cache;
+
+	// NOTE: evict the least recently edited chunk, it keeps its meshes until its next rebuild
+	int lru = 0;
+	for (int i = 1; i < EDIT_CACHE_SIZE; i++)
+	{
+		if (state->edit_caches[i].last_used < state->edit_caches[lru].last_used)
+			lru = i;
+	}
+
+	cache = &state->edit_caches[lru];
+	if (cache->chunk && cache->chunk->edit_cache == lru)
+	{
+		if (cache->shadow_dirty)
+			rebuild_shadow_mesh(memory, cache->chunk, cache->chunk->blocks, GL_STATIC_DRAW);
+		cache->chunk->edit_cache = -1;
+	}
+
+	cache->chunk = chunk;
+	cache->nranges = 0;
+	cache->last_used = state->frameCount;
+	cache->shadow_dirty = false;
+	chunk->edit_cache = lru;
+
+	return cache;
+}
+
+// NOTE: position only mesh for the shadow passes, all solid blocks are merged regardless of type,
+// so boxes can span several types and faces between types disappear
+void rebuild_shadow_mesh(Game_memory *memory, Chunk *chunk, const uint8_t *blocks, GLenum usage) {
+	Mesh *mesh = &chunk->shadow_mesh;
+	uint8_t *solid = memory->solid_blocks;
+	Range3d *ranges = memory->ranges;
+
+	for (int i = 0; i < BLOCKS_IN_CHUNK; i++)
+	{
+		solid[i] = (blocks[i] != BLOCK_AIR) ? BLOCK_STONE : BLOCK_AIR;
+	}
+
+	int nranges = 0;
+	gen_ranges_bitmask(solid, ranges, &memory->masks, &nranges);
+
+	int num_of_vs = 0;
+	for (int i = 0; i < nranges; i++)
+	{
+		num_of_vs += range_vertex_count(&ranges[i]);
+	}
+
+	if (num_of_vs == 0)
+	{
+		free_mesh(mesh);
+		return;
+	}
+
+	Memory_arena *arena = scratch_arena(memory);
+	Arena_scope scratch(arena);
+	Vec3f *vs = ARENA_PUSH_ARRAY(arena, Vec3f, num_of_vs);
+
+	int v_idx = 0;
+	for (int i = 0; i < nranges; i++)
+	{
+		v_idx += gen_range_vertices(&ranges[i], vs + v_idx, nullptr);
+	}
+
+	if (mesh->vao == 0)
+	{
+		glGenVertexArrays(1, &mesh->vao);
+		glGenBuffers(1, &mesh->vbo);
 	}
+
+	glBindVertexArray(mesh->vao);
+	glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
+
+	glBufferData(GL_ARRAY_BUFFER, num_of_vs * sizeof(Vec3f), vs, usage);
+	set_mesh_buffer_bytes(mesh, num_of_vs * sizeof(Vec3f));
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 3, (void *)0);
+	glEnableVertexAttribArray(0);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	mesh->num_of_vs = num_of_vs;
+	mesh->capacity = num_of_vs;
 }
 
 void rebuild_chunk(Game_memory *memory, Chunk *chunk) {
+	TRACE_SCOPE("rebuild_chunk");
+	PROFILE_COUNT(PROFILER_COUNTER_CHUNKS_REBUILT, 1);
+
+	// NOTE: chunks that are being edited keep their ranges and get spare room in their buffers,
+	// so that the next edits can be patched in place
+	Chunk_edit_cache *cache = find_edit_cache(memory->game_state, chunk);
+	if (cache && chunk->lod != 0)
+	{
+		// NOTE: coarse meshes can't be patched, the chunk gets a new cache when it is edited again
+		cache->chunk = nullptr;
+		chunk->edit_cache = -1;
+		cache = nullptr;
+	}
+
+	if (cache)
+	{
+		cache->nranges = 0;
+		cache->shadow_dirty = false;
+		cache->shadow_built = memory->game_state->frameCount;
+	}
+
+	chunk->connectivity = chunk->nblocks ? gen_face_connectivity(chunk->blocks, &memory->masks) : ALL_FACES_CONNECTED;
+
 	if (chunk->nblocks) {
 		Range3d *ranges = memory->ranges;
-		uint8_t *visited = memory->visited;
+		Chunk_masks *masks = &memory->masks;
 
-		if (ranges && visited)
+		uint8_t *blocks = chunk->blocks;
+		if (chunk->lod != 0)
 		{
-			for (int i = 0; i < (BLOCKS_IN_CHUNK); i++) visited[i] = 0;
-             
-			int nranges = 0;
-			gen_ranges_3d(chunk->blocks, ranges, visited, CHUNK_DIM, chunk->nblocks, &nranges);
+			downsample_blocks(chunk->blocks, memory->lod_blocks, chunk->lod);
+			blocks = memory->lod_blocks;
+		}
 
-			// NOTE(max): sort ranges by block type
-			for (int i = 0; i < nranges - 1; i++)
+		int nranges = 0;
+		gen_ranges_bitmask(blocks, ranges, masks, &nranges);
+		sort_ranges_by_type(ranges, nranges);
+
+		int rebuilded_mesh_types[BLOCK_TYPE_COUNT] = {};
+
+		int ranges_left = nranges;
+		int ranges_idx_start = 0;
+		int ranges_idx_end  = 0;
+		while (ranges_left > 0)
+		{
+			int ranges_count = 0;
+			uint8_t range_type = ranges[ranges_idx_start].type;
+			while ((ranges_idx_end < nranges) && ranges[ranges_idx_end].type == range_type)
+			{
+				ranges_count++;
+				ranges_idx_end++;
+			}
+			ranges_left -= ranges_count;
+
+			assert(range_type < BLOCK_TYPE_COUNT);
+			Mesh *mesh_to_rebuild = &chunk->meshes[range_type];
+
+			// NOTE: vertices are grouped by face direction, so draws can skip the directions facing away from the camera
+			int face_vs[FACE_COUNT] = {};
+			for (int i = ranges_idx_start; i < ranges_idx_end; i++)
 			{
-				for (int j = 0; j < nranges - i - 1; j++)
+				for (int f = 0; f < FACE_COUNT; f++)
 				{
-					if (ranges[j].type > ranges[j + 1].type)
-					{
-						Range3d temp = ranges[j + 1];
-						ranges[j + 1] = ranges[j];
-						ranges[j] = temp;
-					}
+					if (ranges[i].faces & (1 << f))
+						face_vs[f] += VERTICES_PER_FACE;
 				}
 			}
 
-			int rebuilded_mesh_types[BLOCK_TYPE_COUNT] = {};
+			int num_of_vs = 0;
+			int capacity = 0;
+			for (int f = 0; f < FACE_COUNT; f++)
+			{
+				mesh_to_rebuild->face_first[f] = capacity;
+				mesh_to_rebuild->face_vs[f] = face_vs[f];
+				mesh_to_rebuild->face_capacity[f] = face_vs[f] + (cache ? EDIT_FACE_HEADROOM_VS : 0);
+				num_of_vs += face_vs[f];
+				capacity += mesh_to_rebuild->face_capacity[f];
+			}
 
-			int ranges_left = nranges;
-			int ranges_idx_start = 0;
-			int ranges_idx_end  = 0;
-			while (ranges_left > 0)
+			int vs_arr_size = capacity * sizeof(Vec3f);
+			int ns_arr_size = capacity * sizeof(Vec3f);
+			Memory_arena *arena = scratch_arena(memory);
+			Arena_scope scratch(arena);
+			Vec3f *vs = ARENA_PUSH_ARRAY(arena, Vec3f, 2 * capacity);
+			Vec3f *ns = vs + capacity;
+			if (vs)
 			{
-				int ranges_count = 0;
-				uint8_t range_type = ranges[ranges_idx_start].type;
-				while ((ranges_idx_end < nranges) && ranges[ranges_idx_end].type == range_type)
+				rebuilded_mesh_types[range_type] = 1;
+
+				int face_cursor[FACE_COUNT];
+				for (int f = 0; f < FACE_COUNT; f++)
 				{
-					ranges_count++;
-					ranges_idx_end++;
+					face_cursor[f] = mesh_to_rebuild->face_first[f];
 				}
-				ranges_left -= ranges_count;
 
-				assert(range_type < BLOCK_TYPE_COUNT);
-				Mesh *mesh_to_rebuild = &chunk->meshes[range_type];
-
-				int vs_arr_size = 3 * 12 * ranges_count * sizeof(Vec3f);
-				int ns_arr_size = 3 * 12 * ranges_count * sizeof(Vec3f);
-				Vec3f *vs = (Vec3f*) memory->transient_mem;
-				printf("%p\n", vs);
-				Vec3f *ns = vs + (3 * 12 * ranges_count);
-				if (vs)
+				mesh_to_rebuild->num_of_vs = num_of_vs;
+				mesh_to_rebuild->capacity = capacity;
+				mesh_to_rebuild->dead_vs = 0;
+				for (int i = ranges_idx_start; i < ranges_idx_end; i++)
 				{
-					rebuilded_mesh_types[range_type] = 1;
+					Mesh_range mesh_range;
+					mesh_range.range = ranges[i];
 
-					int v_idx = 0;
-					mesh_to_rebuild->num_of_vs = 3 * 12 * ranges_count;
-					for (int i = ranges_idx_start; i < ranges_idx_end; i++)
+					for (int f = 0; f < FACE_COUNT; f++)
 					{
-						Vec3f base((float)ranges[i].start_x, (float)ranges[i].start_y, (float)ranges[i].start_z);
-
-						float dim_x = (float)ranges[i].end_x - base.x + 1.0f;
-						float dim_y = (float)ranges[i].end_y - base.y + 1.0f;
-						float dim_z = (float)ranges[i].end_z - base.z + 1.0f;
-
-						// TODO(max): check for correct winding order
-
-						Vec3f bottom_n(0, -1, 0);
-						Vec3f top_n(0, 1, 0);
-						Vec3f north_n(0, 0, -1);
-						Vec3f south_n(0, 0, 1);
-						Vec3f west_n(-1, 0, 0);
-						Vec3f east_n(1, 0, 0);
-
-						// bottom tri 0
-						vs[v_idx + 0 * 3 + 0] = base;
-						vs[v_idx + 0 * 3 + 1] = base + Vec3f(dim_x, 0, 0);
-						vs[v_idx + 0 * 3 + 2] = base + Vec3f(0, 0, dim_z);
-
-						ns[v_idx + 0 * 3 + 0] = bottom_n;
-						ns[v_idx + 0 * 3 + 1] = bottom_n;
-						ns[v_idx + 0 * 3 + 2] = bottom_n;
-
-						// bottom tri 1
-						vs[v_idx + 1 * 3 + 0] = base + Vec3f(0, 0, dim_z);
-						vs[v_idx + 1 * 3 + 1] = base + Vec3f(dim_x, 0, 0);
-						vs[v_idx + 1 * 3 + 2] = base + Vec3f(dim_x, 0, dim_z);
-
-						ns[v_idx + 1 * 3 + 0] = bottom_n;
-						ns[v_idx + 1 * 3 + 1] = bottom_n;
-						ns[v_idx + 1 * 3 + 2] = bottom_n;
-
-						// top tri 0
-						vs[v_idx + 2 * 3 + 0] = base + Vec3f(0, dim_y, 0);
-						vs[v_idx + 2 * 3 + 1] = base + Vec3f(0, dim_y, dim_z);
-						vs[v_idx + 2 * 3 + 2] = base + Vec3f(dim_x, dim_y, 0);
-
-						ns[v_idx + 2 * 3 + 0] = top_n;
-						ns[v_idx + 2 * 3 + 1] = top_n;
-						ns[v_idx + 2 * 3 + 2] = top_n;
-
-						// top tri 1
-						vs[v_idx + 3 * 3 + 0] = base + Vec3f(0, dim_y, dim_z);
-						vs[v_idx + 3 * 3 + 1] = base + Vec3f(dim_x, dim_y, dim_z);
-						vs[v_idx + 3 * 3 + 2] = base + Vec3f(dim_x, dim_y, 0);
-
-						ns[v_idx + 3 * 3 + 0] = top_n;
-						ns[v_idx + 3 * 3 + 1] = top_n;
-						ns[v_idx + 3 * 3 + 2] = top_n;
-
-						// north tri 0
-						vs[v_idx + 4 * 3 + 0] = base;
-						vs[v_idx + 4 * 3 + 1] = base + Vec3f(0, dim_y, 0);
-						vs[v_idx + 4 * 3 + 2] = base + Vec3f(dim_x, dim_y, 0);
-
-						ns[v_idx + 4 * 3 + 0] = north_n;
-						ns[v_idx + 4 * 3 + 1] = north_n;
-						ns[v_idx + 4 * 3 + 2] = north_n;
-
-						// north tri 1
-						vs[v_idx + 5 * 3 + 0] = base;
-						vs[v_idx + 5 * 3 + 1] = base + Vec3f(dim_x, dim_y, 0);
-						vs[v_idx + 5 * 3 + 2] = base + Vec3f(dim_x, 0, 0);
-
-						ns[v_idx + 5 * 3 + 0] = north_n;
-						ns[v_idx + 5 * 3 + 1] = north_n;
-						ns[v_idx + 5 * 3 + 2] = north_n;
-
-						// south tri 0
-						vs[v_idx + 6 * 3 + 0] = base + Vec3f(0, 0, dim_z);
-						vs[v_idx + 6 * 3 + 1] = base + Vec3f(dim_x, dim_y, dim_z);
-						vs[v_idx + 6 * 3 + 2] = base + Vec3f(0, dim_y, dim_z);
-
-						ns[v_idx + 6 * 3 + 0] = south_n;
-						ns[v_idx + 6 * 3 + 1] = south_n;
-						ns[v_idx + 6 * 3 + 2] = south_n;
-
-						// south tri 1
-						vs[v_idx + 7 * 3 + 0] = base + Vec3f(0, 0, dim_z);
-						vs[v_idx + 7 * 3 + 1] = base + Vec3f(dim_x, 0, dim_z);
-						vs[v_idx + 7 * 3 + 2] = base + Vec3f(dim_x, dim_y, dim_z);
-
-						ns[v_idx + 7 * 3 + 0] = south_n;
-						ns[v_idx + 7 * 3 + 1] = south_n;
-						ns[v_idx + 7 * 3 + 2] = south_n;
-
-						// west tri 0
-						vs[v_idx + 8 * 3 + 0] = base;
-						vs[v_idx + 8 * 3 + 1] = base + Vec3f(0, dim_y, dim_z);
-						vs[v_idx + 8 * 3 + 2] = base + Vec3f(0, dim_y, 0);
-
-						ns[v_idx + 8 * 3 + 0] = west_n;
-						ns[v_idx + 8 * 3 + 1] = west_n;
-						ns[v_idx + 8 * 3 + 2] = west_n;
-
-						// west tri 1
-						vs[v_idx + 9 * 3 + 0] = base;
-						vs[v_idx + 9 * 3 + 1] = base + Vec3f(0, 0, dim_z);
-						vs[v_idx + 9 * 3 + 2] = base + Vec3f(0, dim_y, dim_z);
-
-						ns[v_idx + 9 * 3 + 0] = west_n;
-						ns[v_idx + 9 * 3 + 1] = west_n;
-						ns[v_idx + 9 * 3 + 2] = west_n;
-
-						// east tri 0
-						vs[v_idx + 10 * 3 + 0] = base + Vec3f(dim_x, 0, 0);
-						vs[v_idx + 10 * 3 + 1] = base + Vec3f(dim_x, dim_y, 0);
-						vs[v_idx + 10 * 3 + 2] = base + Vec3f(dim_x, dim_y, dim_z);
-
-						ns[v_idx + 10 * 3 + 0] = east_n;
-						ns[v_idx + 10 * 3 + 1] = east_n;
-						ns[v_idx + 10 * 3 + 2] = east_n;
-
-						// east tri 1
-						vs[v_idx + 11 * 3 + 0] = base + Vec3f(dim_x, 0, 0);
-						vs[v_idx + 11 * 3 + 1] = base + Vec3f(dim_x, dim_y, dim_z);
-						vs[v_idx + 11 * 3 + 2] = base + Vec3f(dim_x, 0, dim_z);
-
-						ns[v_idx + 11 * 3 + 0] = east_n;
-						ns[v_idx + 11 * 3 + 1] = east_n;
-						ns[v_idx + 11 * 3 + 2] = east_n;
-
-						v_idx += (3 * 12);
+						mesh_range.first_v[f] = -1;
+						if (ranges[i].faces & (1 << f))
+						{
+							int v_idx = face_cursor[f];
+							gen_range_face_vertices(&ranges[i], 1 << f, vs + v_idx, ns + v_idx);
+							mesh_range.first_v[f] = v_idx;
+							face_cursor[f] += VERTICES_PER_FACE;
+						}
 					}
 
-					assert(v_idx == mesh_to_rebuild->num_of_vs);
+					if (cache)
+						cache->ranges[cache->nranges++] = mesh_range;
+				}
 
-					if (mesh_to_rebuild->vao == 0)
-					{
-						assert((mesh_to_rebuild->vao == 0) && (mesh_to_rebuild->vbo == 0));
-						glGenVertexArrays(1, &mesh_to_rebuild->vao);
-						glGenBuffers(1, &mesh_to_rebuild->vbo);
-					}
+				for (int f = 0; f < FACE_COUNT; f++)
+				{
+					assert(face_cursor[f] == mesh_to_rebuild->face_first[f] + mesh_to_rebuild->face_vs[f]);
+				}
+
+				if (mesh_to_rebuild->vao == 0)
+				{
+					assert((mesh_to_rebuild->vao == 0) && (mesh_to_rebuild->vbo == 0));
+					glGenVertexArrays(1, &mesh_to_rebuild->vao);
+					glGenBuffers(1, &mesh_to_rebuild->vbo);
+				}
+
+				glBindVertexArray(mesh_to_rebuild->vao);
+				glBindBuffer(GL_ARRAY_BUFFER, mesh_to_rebuild->vbo);
+
+				glBufferData(GL_ARRAY_BUFFER, vs_arr_size + ns_arr_size, vs, cache ? GL_DYNAMIC_DRAW : GL_STREAM_DRAW);
+				set_mesh_buffer_bytes(mesh_to_rebuild, vs_arr_size + ns_arr_size);
+				glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 3, (void *)0);
+				glEnableVertexAttribArray(0);
+				glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 3, (char *)(0) + vs_arr_size);
+				glEnableVertexAttribArray(1);
+
+				glBindVertexArray(0);
+				glBindBuffer(GL_ARRAY_BUFFER, 0);
+			}
+
+			ranges_idx_start = ranges_idx_end;
+		}
+
+		for (int i = 0; i < BLOCK_TYPE_COUNT; i++)
+		{
+			if (rebuilded_mesh_types[i] == 0)
+			{
+				free_mesh(&chunk->meshes[i]);
+			}
+		}
+
+		rebuild_shadow_mesh(memory, chunk, blocks, cache ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+	}
+	else
+	{
+		for (int i = 0; i < BLOCK_TYPE_COUNT; i++)
+		{
+			free_mesh(&chunk->meshes[i]);
+		}
+		free_mesh(&chunk->shadow_mesh);
+	}
+}
+
+// NOTE: writes one face of a range into its slot, degenerate triangles when the range doesn't draw that face
+void write_mesh_face(Chunk *chunk, Mesh_range *r, int face) {
+	Vec3f vs[VERTICES_PER_FACE] = {};
+	Vec3f ns[VERTICES_PER_FACE] = {};
+	if (r->range.faces & (1 << face))
+		gen_range_face_vertices(&r->range, 1 << face, vs, ns);
+
+	Mesh *mesh = &chunk->meshes[r->range.type];
+	glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
+	glBufferSubData(GL_ARRAY_BUFFER, r->first_v[face] * sizeof(Vec3f), sizeof(vs), vs);
+	glBufferSubData(GL_ARRAY_BUFFER, (mesh->capacity + r->first_v[face]) * sizeof(Vec3f), sizeof(ns), ns);
+}
+
+// NOTE: changes the faces a range draws. A face that was dropped keeps its slot for later,
+// a face without a slot gets one at the end of its face group, fails when that group is full.
+bool set_mesh_range_faces(Chunk *chunk, Mesh_range *r, uint8_t faces) {
+	Mesh *mesh = &chunk->meshes[r->range.type];
+	uint8_t old_faces = r->range.faces;
+	r->range.faces = faces;
+
+	for (int f = 0; f < FACE_COUNT; f++)
+	{
+		bool had_face = (old_faces & (1 << f)) != 0;
+		bool wants_face = (faces & (1 << f)) != 0;
+		if (had_face == wants_face)
+			continue;
+
+		if (r->first_v[f] < 0)
+		{
+			if (mesh->face_vs[f] + VERTICES_PER_FACE > mesh->face_capacity[f])
+				return false;
+
+			r->first_v[f] = mesh->face_first[f] + mesh->face_vs[f];
+			mesh->face_vs[f] += VERTICES_PER_FACE;
+			mesh->num_of_vs += VERTICES_PER_FACE;
+		}
+		else
+		{
+			mesh->dead_vs += wants_face ? -VERTICES_PER_FACE : VERTICES_PER_FACE;
+		}
+
+		write_mesh_face(chunk, r, f);
+	}
+
+	return true;
+}
+
+// NOTE: turns all faces of a range into degenerate triangles,
+// the range stays in the cache as BLOCK_AIR until the next full rebuild
+void kill_mesh_range(Chunk *chunk, Mesh_range *r) {
+	set_mesh_range_faces(chunk, r, 0);
+	r->range.type = BLOCK_AIR;
+}
+
+// NOTE: adds a range to the cache and gives its faces slots, fails if the spare room of the mesh is used up
+bool append_mesh_range(Chunk *chunk, Chunk_edit_cache *cache, Range3d range) {
+	Mesh *mesh = &chunk->meshes[range.type];
 
-					glBindVertexArray(mesh_to_rebuild->vao);
-					glBindBuffer(GL_ARRAY_BUFFER, mesh_to_rebuild->vbo);
+	if (cache->nranges >= BLOCKS_IN_CHUNK || mesh->vao == 0)
+		return false;
+
+	Mesh_range *r = &cache->ranges[cache->nranges++];
+	r->range = range;
+	r->range.faces = 0;
+	for (int f = 0; f < FACE_COUNT; f++)
+	{
+		r->first_v[f] = -1;
+	}
+
+	return set_mesh_range_faces(chunk, r, range.faces);
+}
+
+// NOTE: updates the meshes of a chunk in place after the block at block_idx has changed.
+// Only the range that contained the block is split and the ranges around it get their faces
+// updated. Returns false when the chunk has to be rebuilt from scratch instead.
+bool patch_chunk(Game_memory *memory, Chunk *chunk, Chunk_edit_cache *cache, int block_idx) {
+	if (chunk->nblocks == 0)
+		return false;
+
+	Chunk_masks *masks = &memory->masks;
+	build_chunk_masks(chunk->blocks, masks);
+
+	int x = block_idx % CHUNK_DIM;
+	int z = (block_idx / CHUNK_DIM) % CHUNK_DIM;
+	int y = block_idx / (CHUNK_DIM * CHUNK_DIM);
+
+	// NOTE: iterate over the ranges that were there before the edit, split ones are appended
+	int old_nranges = cache->nranges;
+	for (int i = 0; i < old_nranges; i++)
+	{
+		Mesh_range *r = &cache->ranges[i];
+		Range3d range = r->range;
+
+		bool contains_block = x >= range.start_x && x <= range.end_x &&
+		                      y >= range.start_y && y <= range.end_y &&
+		                      z >= range.start_z && z <= range.end_z;
+		bool touches_block = x >= range.start_x - 1 && x <= range.end_x + 1 &&
+		                     y >= range.start_y - 1 && y <= range.end_y + 1 &&
+		                     z >= range.start_z - 1 && z <= range.end_z + 1;
+		if (range.type == BLOCK_AIR || !touches_block)
+			continue;
+
+		if (contains_block)
+		{
+			// NOTE: the range loses the block, replace it with up to 6 ranges around the block
+			Range3d pieces[6];
+			int npieces = 0;
+
+			if (y > range.start_y) { pieces[npieces] = range; pieces[npieces].end_y = y - 1; npieces++; }
+			if (y < range.end_y)   { pieces[npieces] = range; pieces[npieces].start_y = y + 1; npieces++; }
+
+			Range3d layer = range;
+			layer.start_y = layer.end_y = y;
+			if (z > range.start_z) { pieces[npieces] = layer; pieces[npieces].end_z = z - 1; npieces++; }
+			if (z < range.end_z)   { pieces[npieces] = layer; pieces[npieces].start_z = z + 1; npieces++; }
+
+			Range3d row = layer;
+			row.start_z = row.end_z = z;
+			if (x > range.start_x) { pieces[npieces] = row; pieces[npieces].end_x = x - 1; npieces++; }
+			if (x < range.end_x)   { pieces[npieces] = row; pieces[npieces].start_x = x + 1; npieces++; }
+
+			kill_mesh_range(chunk, r);
+
+			for (int p = 0; p < npieces; p++)
+			{
+				pieces[p].faces = range_exposed_faces(masks, &pieces[p]);
+				if (!append_mesh_range(chunk, cache, pieces[p]))
+					return false;
+			}
+		}
+		else
+		{
+			// NOTE: a neighbour of the block, only its faces can have changed
+			uint8_t faces = range_exposed_faces(masks, &range);
+			if (faces != range.faces && !set_mesh_range_faces(chunk, r, faces))
+				return false;
+		}
+	}
 
-					glBufferData(GL_ARRAY_BUFFER, vs_arr_size + ns_arr_size, vs, GL_STREAM_DRAW);
-					glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 3, (void *)0);
-					glEnableVertexAttribArray(0);
-					glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 3, (char *)(0) + vs_arr_size);
-					glEnableVertexAttribArray(1);
+	uint8_t block_type = chunk->blocks[block_idx];
+	if (block_type != BLOCK_AIR)
+	{
+		Range3d range = { block_type, 0, x, y, z, x, y, z };
+		range.faces = range_exposed_faces(masks, &range);
+		if (!append_mesh_range(chunk, cache, range))
+			return false;
+	}
 
-					glBindVertexArray(0);
-					glBindBuffer(GL_ARRAY_BUFFER, 0);
-				}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-				ranges_idx_start = ranges_idx_end;
-			}
+	// NOTE: rebuild once most of a mesh is degenerate triangles
+	for (int i = 0; i < BLOCK_TYPE_COUNT; i++)
+	{
+		Mesh *m = &chunk->meshes[i];
+		if (m->dead_vs > FACE_COUNT * EDIT_FACE_HEADROOM_VS && m->dead_vs * 2 > m->num_of_vs)
+			return false;
+	}
 
-			for (int i = 0; i < BLOCK_TYPE_COUNT; i++)
-			{
-				if (rebuilded_mesh_types[i] == 0)
-				{
-					Mesh *m = &chunk->meshes[i];
-					if (m->vao != 0)
-					{
-						assert(m->vao && m->vbo);
+	return true;
+}
 
-						glDeleteVertexArrays(1, &m->vao);
-						glDeleteBuffers(1, &m->vbo);
+void apply_block_edit(Game_memory *memory, Chunk *chunk, int block_idx) {
+	Game_state *state = memory->game_state;
+	Chunk_edit_cache *cache = find_edit_cache(state, chunk);
 
-						m->num_of_vs = 0;
-						m->vao = 0;
-						m->vbo = 0;
-					}
-				}
-			}
-		}
+	if (!cache || chunk->lod != 0 || !patch_chunk(memory, chunk, cache, block_idx))
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		if (chunk->lod == 0)
+			acquire_edit_cache(memory, chunk);
+		rebuild_chunk(memory, chunk);
 	}
 	else
 	{
-		for (int i = 0; i < BLOCK_TYPE_COUNT; i++)
-		{
-			Mesh *m = &chunk->meshes[i];
-			if (m->vao != 0)
-			{
-				assert(m->vao && m->vbo);
+		chunk->connectivity = gen_face_connectivity(chunk->blocks, &memory->masks);
+		cache->shadow_dirty = true;
+	}
+}
 
-				glDeleteVertexArrays(1, &m->vao);
-				glDeleteBuffers(1, &m->vbo);
+// NOTE: remeshes the shadow meshes that patched edits left behind, see Chunk_edit_cache
+void rebuild_edited_shadow_meshes(Game_memory *memory) {
+	Game_state *state = memory->game_state;
+	for (int i = 0; i < EDIT_CACHE_SIZE; i++)
+	{
+		Chunk_edit_cache *cache = &state->edit_caches[i];
+		if (!cache->chunk || !cache->shadow_dirty)
+			continue;
 
-				m->num_of_vs = 0;
-				m->vao = 0;
-				m->vbo = 0;
-			}
-		}
+		bool editing = cache->last_used == (uint64_t) state->frameCount;
+		if (editing && (uint64_t) state->frameCount - cache->shadow_built < EDIT_SHADOW_REBUILD_FRAMES)
+			continue;
+
+		rebuild_shadow_mesh(memory, cache->chunk, cache->chunk->blocks, GL_DYNAMIC_DRAW);
+		cache->shadow_dirty = false;
+		cache->shadow_built = state->frameCount;
 	}
 }
 
-bool chunk_exists(Game_state *state, int x, int y, int z) {
-	for (Chunk *c : state->world.visible_chunks) {
-		if (c->x == x && c->y == y && c->z == z) 
-			return true;
-	}
+// NOTE: LOD a chunk should be drawn at, distance is in chunks like WORLD_RADIUS.
+// A chunk only goes back to a finer LOD one chunk closer than where it went coarser,
+// so moving back and forth over a boundary doesn't rebuild it every time.
+int chunk_lod(Chunk *c, int cam_chunk_x, int cam_chunk_z) {
+	int dist = std::max(abs(cam_chunk_x - c->x), abs(cam_chunk_z - c->z));
+
+	int lod = c->lod;
+	int coarser = (dist > LOD_2_DISTANCE) ? 2 : (dist > LOD_1_DISTANCE) ? 1 : 0;
+	int finer = (dist + 1 > LOD_2_DISTANCE) ? 2 : (dist + 1 > LOD_1_DISTANCE) ? 1 : 0;
+
+	if (coarser > lod)
+		lod = coarser;
+	else if (finer < lod)
+		lod = finer;
 
-	return false;
+	return (lod);
+}
+
+bool chunk_exists(Game_state *state, int x, int y, int z) {
+	return state->world.find_chunk(x, y, z) != nullptr;
 }
 
 void frustum_culling_perspective(Game_state *state, glm::vec3 cameraPos, glm::vec3 cameraViewDir, float nearZ, float farZ) {
@@ -766,186 +1566,293 @@ void game_update_and_render(Game_input *input, Game_memory *memory)
 {
     assert(memory->is_initialized);
     Game_state *state = memory->game_state;
+    PROFILE_SCOPE("Frame");
+
+    arena_reset(&memory->frame_arena);
+    arena_next_frame(&memory->frame_arena);
+    for (int i = 0; i < SCRATCH_ARENA_COUNT; i++)
+    {
+        arena_next_frame(&memory->scratch_arenas[i]);
+    }
 
     /* logic update */
     {
-        state->cam_rot.pitch += input->mouse_dy;
-        state->cam_rot.yaw += input->mouse_dx;
+        PROFILE_SCOPE("Update");
 
-        if (state->cam_rot.pitch > 89.0f)
-        {
-            state->cam_rot.pitch = 89.0f;
-        }
-        if (state->cam_rot.pitch < -89.0f)
         {
-            state->cam_rot.pitch = -89.0f;
-        }
+            PROFILE_SCOPE("Input");
 
-        Vec3f view_dir;
-        view_dir.x = cosf(TO_RADIANS(state->cam_rot.yaw)) * cosf(TO_RADIANS(state->cam_rot.pitch));
-        view_dir.y = sinf(TO_RADIANS(state->cam_rot.pitch));
-        view_dir.z = sinf(TO_RADIANS(state->cam_rot.yaw)) * cosf(TO_RADIANS(state->cam_rot.pitch));
-        state->cam_view_dir = normalize(view_dir);
+            state->cam_rot.pitch += input->mouse_dy;
+            state->cam_rot.yaw += input->mouse_dx;
 
-        Vec3f move_dir;
-        move_dir = state->cam_view_dir;
-        move_dir.y = 0.0f;
-        state->cam_move_dir = normalize(move_dir);
+            if (state->cam_rot.pitch > 89.0f)
+            {
+                state->cam_rot.pitch = 89.0f;
+            }
+            if (state->cam_rot.pitch < -89.0f)
+            {
+                state->cam_rot.pitch = -89.0f;
+            }
 
-        float cam_speed = 10.0f * input->dt;
-        if (input->w.is_pressed)
-        {
-            state->cam_pos = state->cam_pos + state->cam_move_dir * cam_speed;
-        }
-        if (input->s.is_pressed)
-        {
-            state->cam_pos = state->cam_pos + state->cam_move_dir * -cam_speed;
-        }
+            Vec3f view_dir;
+            view_dir.x = cosf(TO_RADIANS(state->cam_rot.yaw)) * cosf(TO_RADIANS(state->cam_rot.pitch));
+            view_dir.y = sinf(TO_RADIANS(state->cam_rot.pitch));
+            view_dir.z = sinf(TO_RADIANS(state->cam_rot.yaw)) * cosf(TO_RADIANS(state->cam_rot.pitch));
+            state->cam_view_dir = normalize(view_dir);
+
+            Vec3f move_dir;
+            move_dir = state->cam_view_dir;
+            move_dir.y = 0.0f;
+            state->cam_move_dir = normalize(move_dir);
+
+            float cam_speed = 10.0f * input->dt;
+            if (input->w.is_pressed)
+            {
+                state->cam_pos = state->cam_pos + state->cam_move_dir * cam_speed;
+            }
+            if (input->s.is_pressed)
+            {
+                state->cam_pos = state->cam_pos + state->cam_move_dir * -cam_speed;
+            }
         
-        Vec3f right = cross(state->cam_move_dir, state->cam_up);
-        if (input->d.is_pressed)
-        {
-            state->cam_pos = state->cam_pos + right * cam_speed;
-        }
-        if (input->a.is_pressed)
-        {
-            state->cam_pos = state->cam_pos + right * -cam_speed;
-        }
+            Vec3f right = cross(state->cam_move_dir, state->cam_up);
+            if (input->d.is_pressed)
+            {
+                state->cam_pos = state->cam_pos + right * cam_speed;
+            }
+            if (input->a.is_pressed)
+            {
+                state->cam_pos = state->cam_pos + right * -cam_speed;
+            }
 
-        if (input->space.is_pressed)
-        {
-            state->cam_pos = state->cam_pos + Vec3f(0, cam_speed, 0);
-        }
-        if (input->lshift.is_pressed)
-        {
-            state->cam_pos = state->cam_pos + Vec3f(0, -cam_speed, 0);
-        }
+            if (input->space.is_pressed)
+            {
+                state->cam_pos = state->cam_pos + Vec3f(0, cam_speed, 0);
+            }
+            if (input->lshift.is_pressed)
+            {
+                state->cam_pos = state->cam_pos + Vec3f(0, -cam_speed, 0);
+            }
 
-        if (input->n1.is_pressed)
-        {
-            state->block_to_place = BLOCK_GRASS;
-        }
-        if (input->n2.is_pressed)
-        {
-            state->block_to_place = BLOCK_DIRT;
-        }
-        if (input->n3.is_pressed)
-        {
-            state->block_to_place = BLOCK_STONE;
-        }
-        if (input->n4.is_pressed)
-        {
-            state->block_to_place = BLOCK_SNOW;
-        }
+            if (input->n1.is_pressed)
+            {
+                state->block_to_place = BLOCK_GRASS;
+            }
+            if (input->n2.is_pressed)
+            {
+                state->block_to_place = BLOCK_DIRT;
+            }
+            if (input->n3.is_pressed)
+            {
+                state->block_to_place = BLOCK_STONE;
+            }
+            if (input->n4.is_pressed)
+            {
+                state->block_to_place = BLOCK_SNOW;
+            }
 
-        // block removal
-        if (input->mleft.is_pressed)
-        {
-            Raycast_result rc = raycast(&state->world, state->cam_pos, state->cam_view_dir);
-            if (rc.collision == true)
+            if (input->f1.is_pressed && !input->f1.was_pressed)
             {
-                int mask = ~((~1) << (CHUNK_DIM_LOG2 - 1));
-                int block_x = rc.i & mask;
-                int block_y = rc.j & mask;
-                int block_z = rc.k & mask;
+                state->depthPrepass = !state->depthPrepass;
+            }
 
-                int block_idx = CHUNK_DIM * CHUNK_DIM * block_y + CHUNK_DIM * block_z + block_x;
-                if (rc.chunk->blocks[block_idx] != BLOCK_AIR)
-                {
-					rc.chunk->changed = true;
-                    rc.chunk->blocks[block_idx] = BLOCK_AIR;
-                    rc.chunk->nblocks--;
-                    state->world.push_chunk_for_rebuild(rc.chunk);
-                }
+            if (input->f2.is_pressed && !input->f2.was_pressed)
+            {
+                state->heightmapShadows = !state->heightmapShadows;
             }
-        }
 
-        // block placement
-        if (input->mright.is_pressed && !input->mright.was_pressed)
-        {
-            Raycast_result rc = raycast(&state->world, state->cam_pos, state->cam_view_dir);
-            if (rc.collision)
+            if (input->f3.is_pressed && !input->f3.was_pressed)
+            {
+                state->shadowQuality = (state->shadowQuality + 1) % SHADOW_QUALITY_COUNT;
+                apply_shadow_quality(state);
+            }
+
+            if (input->f4.is_pressed && !input->f4.was_pressed)
+            {
+                state->profilerOverlay = !state->profilerOverlay;
+            }
+
+            if (input->f5.is_pressed && !input->f5.was_pressed)
             {
-                int last_chunk_x = rc.last_i >> CHUNK_DIM_LOG2;
-                int last_chunk_y = rc.last_j >> CHUNK_DIM_LOG2;
-                int last_chunk_z = rc.last_k >> CHUNK_DIM_LOG2;
+                if (global_gpu_profiler.csv)
+                    gpu_profiler_close_csv();
+                else if (!gpu_profiler_open_csv(GPU_TIMINGS_CSV))
+                    std::cout << "Can't open " << GPU_TIMINGS_CSV << std::endl;
+            }
+
+            if (input->f6.is_pressed && !input->f6.was_pressed)
+            {
+                if (!trace_capturing())
+                    trace_start();
+                else if (!trace_stop())
+                    std::cout << "Can't write the trace" << std::endl;
+            }
 
-                Chunk *prev_chunk = 0;
+            if (input->f7.is_pressed && !input->f7.was_pressed)
+            {
+                if (!dump_memory_report(state, memory))
+                    std::cout << "Can't write the memory report" << std::endl;
+            }
 
-                for (Chunk *c : state->world.visible_chunks)
+            // block removal
+            if (input->mleft.is_pressed)
+            {
+                Raycast_result rc = raycast(&state->world, state->cam_pos, state->cam_view_dir);
+                if (rc.collision == true)
                 {
-                    if ((c->x == last_chunk_x) &&
-                        (c->y == last_chunk_y) &&
-                        (c->z == last_chunk_z))
+                    int mask = ~((~1) << (CHUNK_DIM_LOG2 - 1));
+                    int block_x = rc.i & mask;
+                    int block_y = rc.j & mask;
+                    int block_z = rc.k & mask;
+
+                    int block_idx = CHUNK_DIM * CHUNK_DIM * block_y + CHUNK_DIM * block_z + block_x;
+                    if (rc.chunk->blocks[block_idx] != BLOCK_AIR)
                     {
-                        prev_chunk = c;
-                        break;
+						rc.chunk->changed = true;
+                        rc.chunk->blocks[block_idx] = BLOCK_AIR;
+                        rc.chunk->nblocks--;
+                        state->world.push_block_edit(rc.chunk, block_idx);
                     }
                 }
+            }
 
-                if (!prev_chunk)
+            // block placement
+            if (input->mright.is_pressed && !input->mright.was_pressed)
+            {
+                Raycast_result rc = raycast(&state->world, state->cam_pos, state->cam_view_dir);
+                if (rc.collision)
                 {
-                    prev_chunk = state->world.add_chunk(last_chunk_x, last_chunk_y, last_chunk_z);
-                }
+                    int last_chunk_x = rc.last_i >> CHUNK_DIM_LOG2;
+                    int last_chunk_y = rc.last_j >> CHUNK_DIM_LOG2;
+                    int last_chunk_z = rc.last_k >> CHUNK_DIM_LOG2;
 
-                if (prev_chunk)
-                {
-                    int mask = ~((~1) << (CHUNK_DIM_LOG2 - 1));
-                    int block_x = rc.last_i & mask;
-                    int block_y = rc.last_j & mask;
-                    int block_z = rc.last_k & mask;
+                    Chunk *prev_chunk = state->world.find_chunk(last_chunk_x, last_chunk_y, last_chunk_z);
 
-                    int block_idx = CHUNK_DIM * CHUNK_DIM * block_y + CHUNK_DIM * block_z + block_x;
-                    if (prev_chunk->blocks[block_idx] == BLOCK_AIR)
+                    if (!prev_chunk)
                     {
-                        // TODO(max): assing block type number
-						prev_chunk->changed = true;
-                        prev_chunk->blocks[block_idx] = state->block_to_place;
-                        prev_chunk->nblocks++;
-                        state->world.push_chunk_for_rebuild(prev_chunk);
+                        prev_chunk = state->world.add_chunk(last_chunk_x, last_chunk_y, last_chunk_z);
+                    }
+
+                    if (prev_chunk)
+                    {
+                        int mask = ~((~1) << (CHUNK_DIM_LOG2 - 1));
+                        int block_x = rc.last_i & mask;
+                        int block_y = rc.last_j & mask;
+                        int block_z = rc.last_k & mask;
+
+                        int block_idx = CHUNK_DIM * CHUNK_DIM * block_y + CHUNK_DIM * block_z + block_x;
+                        if (prev_chunk->blocks[block_idx] == BLOCK_AIR)
+                        {
+                            // TODO(max): assing block type number
+							prev_chunk->changed = true;
+                            prev_chunk->blocks[block_idx] = state->block_to_place;
+                            prev_chunk->nblocks++;
+                            state->world.push_block_edit(prev_chunk, block_idx);
+                        }
                     }
                 }
             }
         }
 
-		//Generate new chunks
+		//Patch edited chunks
+		{
+			PROFILE_SCOPE("Patch edits");
+			for (Block_edit &edit : state->world.block_edits) {
+				apply_block_edit(memory, edit.chunk, edit.block_idx);
+
+				int mask = CHUNK_DIM - 1;
+				state->heightmapShadow.blockChanged(state->world,
+					edit.chunk->x * CHUNK_DIM + (edit.block_idx & mask),
+					edit.chunk->y * CHUNK_DIM + (edit.block_idx >> (2 * CHUNK_DIM_LOG2)),
+					edit.chunk->z * CHUNK_DIM + ((edit.block_idx >> CHUNK_DIM_LOG2) & mask));
+			}
+			state->world.block_edits.clear();
+
+			rebuild_edited_shadow_meshes(memory);
+		}
+
 		int cam_chunk_x = (int) state->cam_pos.x >> CHUNK_DIM_LOG2;
 		int cam_chunk_y = (int) state->cam_pos.y >> CHUNK_DIM_LOG2;
 		int cam_chunk_z = (int) state->cam_pos.z >> CHUNK_DIM_LOG2;
+		auto &chunks = state->world.visible_chunks;
 
-		for (int x = cam_chunk_x - WORLD_RADIUS; x <= cam_chunk_x + WORLD_RADIUS; ++x) {
-			for (int z = cam_chunk_z - WORLD_RADIUS; z <= cam_chunk_z + WORLD_RADIUS; ++z) {
-				for (int i = cam_chunk_y - GENERATION_Y_RADIUS; i <= cam_chunk_y + GENERATION_Y_RADIUS; ++i) {
-					if (!chunk_exists(state, x, i, z)) {
-						state->world.load_chunk(x, i, z);
+		//Generate new chunks
+		{
+			PROFILE_SCOPE("Generate");
+
+			for (int x = cam_chunk_x - WORLD_RADIUS; x <= cam_chunk_x + WORLD_RADIUS; ++x) {
+				for (int z = cam_chunk_z - WORLD_RADIUS; z <= cam_chunk_z + WORLD_RADIUS; ++z) {
+					for (int i = cam_chunk_y - GENERATION_Y_RADIUS; i <= cam_chunk_y + GENERATION_Y_RADIUS; ++i) {
+						if (!chunk_exists(state, x, i, z)) {
+							state->world.load_chunk(x, i, z);
+						}
 					}
 				}
 			}
 		}
 
 		//Remove far chunks
-		auto &chunks = state->world.visible_chunks;
-		for (int i = chunks.size() - 1; i >= 0; --i) {
-			Chunk *c = chunks[i];
-
-			int dx = abs(cam_chunk_x - c->x);
-			int dy = abs(cam_chunk_y - c->y);
-			int dz = abs(cam_chunk_z - c->z);
+		{
+			PROFILE_SCOPE("Unload");
+			for (int i = chunks.size() - 1; i >= 0; --i) {
+				Chunk *c = chunks[i];
+
+				int dx = abs(cam_chunk_x - c->x);
+				int dy = abs(cam_chunk_y - c->y);
+				int dz = abs(cam_chunk_z - c->z);
+
+				if (dx > WORLD_RADIUS || dz > WORLD_RADIUS || dy > GENERATION_Y_RADIUS) {
+					// NOTE: the chunk loses its meshes, so a dirty shadow mesh doesn't matter, and unchanged chunks go back to the pool
+					Chunk_edit_cache *cache = find_edit_cache(state, c);
+					if (cache)
+					{
+						cache->chunk = nullptr;
+						c->edit_cache = -1;
+					}
+					state->world.unload_chunk(i);
+				}
+			}
+		}
 
-			if (dx > WORLD_RADIUS || dz > WORLD_RADIUS || dy > GENERATION_Y_RADIUS) {
-				state->world.unload_chunk(i);
+		//Update chunk LODs
+		{
+			PROFILE_SCOPE("LOD");
+			int lod_rebuilds = 0;
+			for (Chunk *c : chunks) {
+				if (lod_rebuilds >= LOD_REBUILDS_PER_FRAME)
+					break;
+
+				int lod = chunk_lod(c, cam_chunk_x, cam_chunk_z);
+				if (lod != c->lod) {
+					c->lod = lod;
+					state->world.push_chunk_for_rebuild(c);
+					lod_rebuilds++;
+				}
 			}
 		}
 
+		//Update far terrain
+		{
+			PROFILE_SCOPE("Far terrain");
+			state->farTerrain.update(state->cam_pos.x, state->cam_pos.z, FAR_TERRAIN_FADE_START - CHUNK_DIM);
+		}
+
 		//Rebuild chunks
-        while (!state->world.rebuild_stack.empty())
-        {
-            rebuild_chunk(memory, state->world.pop_chunk_for_rebuild());
-        }
+		{
+			PROFILE_SCOPE("Rebuild");
+            while (!state->world.rebuild_stack.empty())
+            {
+                Chunk *c = state->world.pop_chunk_for_rebuild();
+                c->lod = chunk_lod(c, cam_chunk_x, cam_chunk_z);
+                rebuild_chunk(memory, c);
+            }
+		}
     }
     
     /* rendering */
     {
+        PROFILE_SCOPE("Render");
+
         glEnable(GL_CULL_FACE);
         glCullFace(GL_BACK);
 
@@ -972,27 +1879,50 @@ void game_update_and_render(Game_input *input, Game_memory *memory)
 		glm::mat4 lightProjectionViewMatrix2 = lightProjection2 * lightView;
 		glm::mat4 lightProjectionViewMatrix3 = lightProjection3 * lightView;
 		glm::mat4 lightProjectionViewMatrix4 = lightProjection4 * lightView;
+		const Shadow_quality &shadowQuality = shadow_qualities[state->shadowQuality];
 		state->meshShadowMapSP.use();
 
-		state->shadowMap1.bind();
-		state->meshShadowMapSP.setMatrix4fv("u_projection_view", lightProjectionViewMatrix1);
-		renderWorld(state, state->meshShadowMapSP);
-		state->shadowMap1.unbind();
+		{
+			PROFILE_SCOPE("Shadow cascade 1");
+			GPU_PROFILE_SCOPE("Shadow cascade 1");
+			state->shadowMap1.bind();
+			state->meshShadowMapSP.setMatrix4fv("u_projection_view", lightProjectionViewMatrix1);
+			renderShadowCasters(state, state->meshShadowMapSP);
+			state->shadowMap1.unbind();
+		}
 
-		state->shadowMap2.bind();
-		state->meshShadowMapSP.setMatrix4fv("u_projection_view", lightProjectionViewMatrix2);
-		renderWorld(state, state->meshShadowMapSP);
-		state->shadowMap2.unbind();
+		if (shadowQuality.cascades > 1) {
+			PROFILE_SCOPE("Shadow cascade 2");
+			GPU_PROFILE_SCOPE("Shadow cascade 2");
+			state->shadowMap2.bind();
+			state->meshShadowMapSP.setMatrix4fv("u_projection_view", lightProjectionViewMatrix2);
+			renderShadowCasters(state, state->meshShadowMapSP);
+			state->shadowMap2.unbind();
+		}
 
-		state->shadowMap3.bind();
-		state->meshShadowMapSP.setMatrix4fv("u_projection_view", lightProjectionViewMatrix3);
-		renderWorld(state, state->meshShadowMapSP);
-		state->shadowMap3.unbind();
+		if (shadowQuality.cascades > 2) {
+			PROFILE_SCOPE("Shadow cascade 3");
+			GPU_PROFILE_SCOPE("Shadow cascade 3");
+			state->shadowMap3.bind();
+			state->meshShadowMapSP.setMatrix4fv("u_projection_view", lightProjectionViewMatrix3);
+			renderShadowCasters(state, state->meshShadowMapSP);
+			state->shadowMap3.unbind();
+		}
 
-		state->shadowMap4.bind();
-		state->meshShadowMapSP.setMatrix4fv("u_projection_view", lightProjectionViewMatrix4);
-		renderWorld(state, state->meshShadowMapSP);
-		state->shadowMap4.unbind();
+		// NOTE: the farthest cascade comes from the heightmap, so its geometry pass is skipped
+		if (state->heightmapShadows) {
+			PROFILE_SCOPE("Heightmap shadows");
+			GPU_PROFILE_SCOPE("Heightmap shadows");
+			state->heightmapShadow.update(cameraPos.x, cameraPos.z, sunPosition);
+		}
+		else if (shadowQuality.cascades > 3) {
+			PROFILE_SCOPE("Shadow cascade 4");
+			GPU_PROFILE_SCOPE("Shadow cascade 4");
+			state->shadowMap4.bind();
+			state->meshShadowMapSP.setMatrix4fv("u_projection_view", lightProjectionViewMatrix4);
+			renderShadowCasters(state, state->meshShadowMapSP);
+			state->shadowMap4.unbind();
+		}
 
 		//World
         state->mesh_sp.use();
@@ -1001,7 +1931,12 @@ void game_update_and_render(Game_input *input, Game_memory *memory)
         state->mesh_sp.setMatrix4fv("u_projection", &projection.m[0][0]);
 
 		glm::vec3 camViewDir(state->cam_view_dir.x, state->cam_view_dir.y, state->cam_view_dir.z);
-		frustum_culling_perspective(state, cameraPos, camViewDir, 0.1f, 200.0f);
+		{
+			PROFILE_SCOPE("Culling");
+			frustum_culling_perspective(state, cameraPos, camViewDir, 0.1f, 200.0f);
+			cave_culling(memory, cameraPos);
+			horizon_culling(state, cameraPos);
+		}
 		
 		Mat4x4f view = mat4x4f_lookat(state->cam_pos, state->cam_pos + state->cam_view_dir, state->cam_up);
 		state->mesh_sp.setMatrix4fv("u_view", &view.m[0][0]);
@@ -1022,29 +1957,64 @@ void game_update_and_render(Game_input *input, Game_memory *memory)
 		glUniform1i(glGetUniformLocation(state->mesh_sp.get(), "depthMap2"), 3);
 		glUniform1i(glGetUniformLocation(state->mesh_sp.get(), "depthMap3"), 4);
 		glUniform1i(glGetUniformLocation(state->mesh_sp.get(), "depthMap4"), 5);
+		glActiveTexture(GL_TEXTURE6);
+		glBindTexture(GL_TEXTURE_2D, state->heightmapShadow.texture());
+		glUniform1i(glGetUniformLocation(state->mesh_sp.get(), "occludedHeights"), 6);
+		glUniform1i(glGetUniformLocation(state->mesh_sp.get(), "heightmapShadows"), state->heightmapShadows);
+		glUniform2f(glGetUniformLocation(state->mesh_sp.get(), "heightmapOrigin"), (float) state->heightmapShadow.originX(), (float) state->heightmapShadow.originZ());
+		glUniform1f(glGetUniformLocation(state->mesh_sp.get(), "heightmapSize"), (float) HEIGHTMAP_SHADOW_SIZE);
+		glUniform1i(glGetUniformLocation(state->mesh_sp.get(), "shadowCascades"), shadowQuality.cascades);
+		glUniform1i(glGetUniformLocation(state->mesh_sp.get(), "shadowTaps"), shadowQuality.taps);
 		state->mesh_sp.setMatrix4fv("lightSpaceMatrix1", lightProjectionViewMatrix1);
 		state->mesh_sp.setMatrix4fv("lightSpaceMatrix2", lightProjectionViewMatrix2);
 		state->mesh_sp.setMatrix4fv("lightSpaceMatrix3", lightProjectionViewMatrix3);
 		state->mesh_sp.setMatrix4fv("lightSpaceMatrix4", lightProjectionViewMatrix4);
 		glUniform1f(glGetUniformLocation(state->mesh_sp.get(), "shadowStrength"), (sunHeight > 0.5f ? 1.0f : std::max(sunHeight * 2.0f, 0.0f)));
 
+		glm::vec3 lightPos = sunPosition;
+		float diffuseStrength;
 		if (sunHeight > 0.2f)
-			state->mesh_sp.set1f("diffuse_strength", 1.0f);
+			diffuseStrength = 1.0f;
 		else if (sunHeight > 0.0f)
-			state->mesh_sp.set1f("diffuse_strength", sunHeight * 5);
+			diffuseStrength = sunHeight * 5;
 		else if (sunHeight > -0.2f) {
-			state->mesh_sp.set1f("diffuse_strength", abs(sunHeight / 2));
-			state->mesh_sp.set3fv("light_pos", -sunPosition);
+			diffuseStrength = abs(sunHeight / 2);
+			lightPos = -sunPosition;
 		}
 		else {
-			state->mesh_sp.set1f("diffuse_strength", 0.1f);
-			state->mesh_sp.set3fv("light_pos", -sunPosition);
+			diffuseStrength = 0.1f;
+			lightPos = -sunPosition;
 		}
+		state->mesh_sp.set1f("diffuse_strength", diffuseStrength);
+		state->mesh_sp.set3fv("light_pos", lightPos);
 
-		renderWorld(state, state->mesh_sp);
+		{
+			PROFILE_SCOPE("World");
+			GPU_PROFILE_SCOPE("World");
+			read_occlusion_queries(state);
+			sort_chunks_front_to_back(state, cameraPos);
+
+			// NOTE: with the prepass the shading pass only runs for the fragments that end up on screen
+			if (state->depthPrepass) {
+				glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+				state->depthPrepassSP.use();
+				state->depthPrepassSP.setMatrix4fv("u_projection", &projection.m[0][0]);
+				state->depthPrepassSP.setMatrix4fv("u_view", &view.m[0][0]);
+				renderWorld(state, state->depthPrepassSP, true);
+				glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+				glDepthFunc(GL_EQUAL);
+				state->mesh_sp.use();
+			}
+
+			renderWorld(state, state->mesh_sp, true);
+			glDepthFunc(GL_LESS);
+			issue_occlusion_queries(state);
+		}
 
 		Raycast_result rc = raycast(&state->world, state->cam_pos, state->cam_view_dir);
 		if (rc.collision) {
+			GPU_PROFILE_SCOPE("Outline");
 			glm::mat4 model(1);
 			model = glm::translate(model, glm::vec3(rc.i + 0.5f, rc.j + 0.5f, rc.k + 0.5f));
 			model = glm::scale(model, glm::vec3(0.51f, 0.51f, 0.51f));
@@ -1061,133 +2031,225 @@ void game_update_and_render(Game_input *input, Game_memory *memory)
 			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 		}
 
+		//Far terrain
+		{
+			PROFILE_SCOPE("Far terrain");
+			GPU_PROFILE_SCOPE("Far terrain");
+			//NOTE: drawn with its own depth range only where no chunk was drawn
+			glEnable(GL_CULL_FACE);
+			glClear(GL_DEPTH_BUFFER_BIT);
+			glStencilFunc(GL_EQUAL, 0, 0xFF);
+
+			Mat4x4f farProjection = mat4x4f_perspective(90.0f, input->aspect_ratio, FAR_TERRAIN_NEAR, state->farTerrain.extent() * 1.5f);
+			Vec3f farColor = Block_colors[BLOCK_STONE];
+			state->farTerrainSP.use();
+			state->farTerrainSP.setMatrix4fv("u_projection", &farProjection.m[0][0]);
+			state->farTerrainSP.setMatrix4fv("u_view", &view.m[0][0]);
+			state->farTerrainSP.set3fv("u_color", glm::vec3(farColor.r, farColor.g, farColor.b));
+			state->farTerrainSP.set3fv("u_camera_pos", cameraPos);
+			state->farTerrainSP.set1f("u_fade_start", FAR_TERRAIN_FADE_START);
+			state->farTerrainSP.set1f("u_fade_end", FAR_TERRAIN_FADE_END);
+			state->farTerrainSP.set3fv("light_pos", lightPos);
+			state->farTerrainSP.set1f("ambient_factor", ambient);
+			state->farTerrainSP.set1f("diffuse_strength", diffuseStrength);
+			state->farTerrain.render();
+		}
+
 		glClear(GL_DEPTH_BUFFER_BIT);
 		glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
 		glStencilFunc(GL_EQUAL, 0, 0xFF);
 
 		//Skybox
-		glm::mat4 viewMatrix;
+		{
+			PROFILE_SCOPE("Skybox");
+			GPU_PROFILE_SCOPE("Skybox");
+			glm::mat4 viewMatrix;
 
-		for (int x = 0; x < 4; ++x)
-			for (int y = 0; y < 4; ++y)
-				viewMatrix[x][y] = view.m[x][y];
+			for (int x = 0; x < 4; ++x)
+				for (int y = 0; y < 4; ++y)
+					viewMatrix[x][y] = view.m[x][y];
 
-		glDepthFunc(GL_LEQUAL);
-		glEnable(GL_DEPTH_CLAMP);
+			glDepthFunc(GL_LEQUAL);
+			glEnable(GL_DEPTH_CLAMP);
 	
-		state->skyboxSP.use();
-		glUniform1f(glGetUniformLocation(state->skyboxSP.get(), "ambientStrength"), ambient * 2);
-		state->skyboxSP.setMatrix4fv("view", glm::mat4(glm::mat3(viewMatrix)));
-		state->skyboxSP.setMatrix4fv("projection", &projection.m[0][0]);
-		state->skyboxSP.set1f("ambient_factor", ambient * 2);
-		glBindVertexArray(state->cubeVAO);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, state->skybox.texture());
-		glDrawArrays(GL_TRIANGLES, 0, 36);
-		glBindVertexArray(0);
-		glDepthFunc(GL_LESS);
-		glDisable(GL_DEPTH_CLAMP);
+			state->skyboxSP.use();
+			glUniform1f(glGetUniformLocation(state->skyboxSP.get(), "ambientStrength"), ambient * 2);
+			state->skyboxSP.setMatrix4fv("view", glm::mat4(glm::mat3(viewMatrix)));
+			state->skyboxSP.setMatrix4fv("projection", &projection.m[0][0]);
+			state->skyboxSP.set1f("ambient_factor", ambient * 2);
+			glBindVertexArray(state->cubeVAO);
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_CUBE_MAP, state->skybox.texture());
+			glDrawArrays(GL_TRIANGLES, 0, 36);
+			glBindVertexArray(0);
+			glDepthFunc(GL_LESS);
+			glDisable(GL_DEPTH_CLAMP);
+		}
 
 		//Sun
-		glEnable(GL_BLEND);
-		glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-		glDepthFunc(GL_LEQUAL);
-		glEnable(GL_DEPTH_CLAMP);
-		glDisable(GL_CULL_FACE);
-		glBindVertexArray(state->squareVAO);
-		glActiveTexture(GL_TEXTURE0);
-		state->sunTexture.bind();
-		state->sunSP.use();
-
-		glm::mat4 model(1);
-		model = glm::translate(model, sunPosition + glm::vec3(state->cam_pos.x, state->cam_pos.y, state->cam_pos.z));
-		glm::vec3 sunPositionProjection(sunPosition.x, sunPosition.y, 0);
-		float angle = 3.14f / 2.0f - acos(glm::dot(glm::normalize(sunPosition), glm::normalize(sunPositionProjection)));
-		glm::vec3 sunRotationAxis = glm::cross(sunPosition, sunPositionProjection);
-		model = glm::rotate(model, angle, sunRotationAxis);
-		model = glm::scale(model, glm::vec3(5.0f, 5.0f, 5.0f));
-
-		state->sunSP.setMatrix4fv("model", model);
-		state->sunSP.setMatrix4fv("view", &view.m[0][0]);
-		state->sunSP.setMatrix4fv("projection", &projection.m[0][0]);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
-		
-		glBindTexture(GL_TEXTURE_2D, 0);
-		glBindVertexArray(0);
-		glDepthFunc(GL_LESS);
-		glDisable(GL_DEPTH_CLAMP);
-
-		//Inventory
-		glStencilFunc(GL_ALWAYS, 0, 0xFF);
-		glDisable(GL_DEPTH_TEST);
-		glCullFace(GL_FRONT);
-
-		Mat4x4f invBlockProjection = mat4x4f_perspective(45.0f, input->aspect_ratio, 0.1f, 10.0f);
-        Mat4x4f invBlockView = mat4x4f_lookat(Vec3f(5.0f, 5.0f, 5.0f), Vec3f(5.0f, 5.0f, 5.0f) + normalize(Vec3f(-1.0f, -1.0f, -1.0f)), Vec3f(0.0f, 1.0f, 0.0f));
-
-		for (int i = 0; i < BLOCK_TYPE_COUNT; ++i) {
-			float slotSize = (state->block_to_place == i) ? 0.07f : 0.05f;
-			float xPosition = (-static_cast<float>(BLOCK_TYPE_COUNT) / 2 + ((BLOCK_TYPE_COUNT % 2) ? 0 : 0.5f) + i) * 0.08f;
-			float yPosition = -1.0f + ((state->block_to_place == i) ? 0.01f + slotSize : 0.03f + slotSize);
+		{
+			PROFILE_SCOPE("Sun");
+			GPU_PROFILE_SCOPE("Sun");
+			glEnable(GL_BLEND);
+			glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-			//Bar slot
+			glDepthFunc(GL_LEQUAL);
+			glEnable(GL_DEPTH_CLAMP);
 			glDisable(GL_CULL_FACE);
-			glActiveTexture(GL_TEXTURE0);
 			glBindVertexArray(state->squareVAO);
-			state->inventoryBarTexture.bind();
-			state->imageSP.use();
+			glActiveTexture(GL_TEXTURE0);
+			state->sunTexture.bind();
+			state->sunSP.use();
 
 			glm::mat4 model(1);
-			model = glm::translate(model, glm::vec3(xPosition, yPosition, 0.0f));
-			model = glm::scale(model, glm::vec3(slotSize / input->aspect_ratio, slotSize, 1.0f));
-			state->imageSP.setMatrix4fv("model", model);
+			model = glm::translate(model, sunPosition + glm::vec3(state->cam_pos.x, state->cam_pos.y, state->cam_pos.z));
+			glm::vec3 sunPositionProjection(sunPosition.x, sunPosition.y, 0);
+			float angle = 3.14f / 2.0f - acos(glm::dot(glm::normalize(sunPosition), glm::normalize(sunPositionProjection)));
+			glm::vec3 sunRotationAxis = glm::cross(sunPosition, sunPositionProjection);
+			model = glm::rotate(model, angle, sunRotationAxis);
+			model = glm::scale(model, glm::vec3(5.0f, 5.0f, 5.0f));
+
+			state->sunSP.setMatrix4fv("model", model);
+			state->sunSP.setMatrix4fv("view", &view.m[0][0]);
+			state->sunSP.setMatrix4fv("projection", &projection.m[0][0]);
 			glDrawArrays(GL_TRIANGLES, 0, 6);
-
-			//Block
-			glEnable(GL_CULL_FACE);
-			glBindVertexArray(state->cubeVAO);
-			state->inventoryBlockSP.use();
-
-			model = glm::translate(glm::mat4(1), glm::vec3(xPosition, yPosition, 0.0f));
-			model = glm::scale(model, glm::vec3(slotSize * 1.2f, slotSize * 1.2f, 1.0f));
-
-			Vec3f color = Block_colors[i];
-			state->inventoryBlockSP.setMatrix4fv("u_model", model);
-			state->inventoryBlockSP.setMatrix4fv("u_view", &invBlockView.m[0][0]);
-			state->inventoryBlockSP.setMatrix4fv("u_projection", &invBlockProjection.m[0][0]);
-			glUniform3f(glGetUniformLocation(state->inventoryBlockSP.get(), "u_color"), color.r, color.g, color.b);
-			glDrawArrays(GL_TRIANGLES, 0, 36);
+		
+			glBindTexture(GL_TEXTURE_2D, 0);
 			glBindVertexArray(0);
+			glDepthFunc(GL_LESS);
+			glDisable(GL_DEPTH_CLAMP);
 		}
 
-		glBindVertexArray(0);
+		//HUD
+		{
+			PROFILE_SCOPE("HUD");
+			GPU_PROFILE_SCOPE("HUD");
+			glStencilFunc(GL_ALWAYS, 0, 0xFF);
+			glDisable(GL_DEPTH_TEST);
+			glDisable(GL_CULL_FACE);
 
-		//FPS
-		drawText(state, input, "FPS: " + std::to_string((int) state->fps), -0.96, 0.96, 0.04);
+			// NOTE: the inventory and the text only change with their inputs or the window size,
+			// otherwise the layer from an earlier frame is composited as it is
+			bool hudResized = state->hudLayer.resize((unsigned int) input->window_width, (unsigned int) input->window_height);
+			if (hudResized || state->hudFps != (int) state->fps || state->hudBlockToPlace != state->block_to_place || state->hudShadowQuality != state->shadowQuality) {
+				state->hudFps = (int) state->fps;
+				state->hudBlockToPlace = state->block_to_place;
+				state->hudShadowQuality = state->shadowQuality;
+
+				state->hudLayer.bind();
+				// NOTE: alpha is accumulated too, the layer ends up premultiplied
+				glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+				Mat4x4f invBlockProjection = mat4x4f_perspective(45.0f, input->aspect_ratio, 0.1f, 10.0f);
+				Mat4x4f invBlockView = mat4x4f_lookat(Vec3f(5.0f, 5.0f, 5.0f), Vec3f(5.0f, 5.0f, 5.0f) + normalize(Vec3f(-1.0f, -1.0f, -1.0f)), Vec3f(0.0f, 1.0f, 0.0f));
+				glm::mat4 invBlockProjectionView = glm::make_mat4(&invBlockProjection.m[0][0]) * glm::make_mat4(&invBlockView.m[0][0]);
+
+				for (int i = 0; i < BLOCK_TYPE_COUNT; ++i) {
+					float slotSize = (state->block_to_place == i) ? 0.07f : 0.05f;
+					float xPosition = (-static_cast<float>(BLOCK_TYPE_COUNT) / 2 + ((BLOCK_TYPE_COUNT % 2) ? 0 : 0.5f) + i) * 0.08f;
+					float yPosition = -1.0f + ((state->block_to_place == i) ? 0.01f + slotSize : 0.03f + slotSize);
+
+					//Bar slot
+					glm::vec2 center(xPosition, yPosition);
+					glm::vec2 size(slotSize / input->aspect_ratio, slotSize);
+					state->hud.quad(center - size, center + size, glm::vec2(0.0f), glm::vec2(1.0f), HUD_TEXTURE_INVENTORY_BAR);
+
+					//Block
+					glm::mat4 model = glm::translate(glm::mat4(1), glm::vec3(xPosition, yPosition, 0.0f));
+					model = glm::scale(model, glm::vec3(slotSize * 1.2f, slotSize * 1.2f, 1.0f));
+					drawInventoryBlock(state, model * invBlockProjectionView, Block_colors[i]);
+				}
 
-		glEnable(GL_DEPTH_TEST);
+				//FPS
+				drawText(state, input, arena_printf(&memory->frame_arena, "FPS: %d", (int) state->fps), -0.96, 0.96, 0.04);
+				drawText(state, input, arena_printf(&memory->frame_arena, "Shadows: %s", shadow_qualities[state->shadowQuality].name), -0.96, 0.90, 0.04);
 
-		//Cross
-		glDisable(GL_CULL_FACE);
-		glActiveTexture(GL_TEXTURE0);
-		glBindVertexArray(state->squareVAO);
-		state->crossTexture.bind();
-		state->imageSP.use();
+				flushHud(state, false);
 
-		model = glm::scale(glm::mat4(1), glm::vec3(0.01f, 0.01f * input->aspect_ratio, 1.0f));
-		state->imageSP.setMatrix4fv("model", model);
-		glEnable(GL_COLOR_LOGIC_OP);
-		glLogicOp(GL_XOR);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
-		glDisable(GL_COLOR_LOGIC_OP);
+				state->hudLayer.unbind();
+			}
 
-		glEnable(GL_DEPTH_TEST);
-		glBindVertexArray(0);
+			glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+			state->hud.quad(glm::vec2(-1.0f), glm::vec2(1.0f), glm::vec2(0.0f), glm::vec2(1.0f), HUD_TEXTURE_LAYER);
+			// NOTE: the overlay changes every frame, so it is drawn on top of the layer instead of into it
+			if (state->profilerOverlay)
+				drawProfilerOverlay(state, memory, input);
+			flushHud(state, true);
+			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+			//Cross
+			glm::vec2 crossSize(0.01f, 0.01f * input->aspect_ratio);
+			state->hud.quad(-crossSize, crossSize, glm::vec2(0.0f), glm::vec2(1.0f), HUD_TEXTURE_CROSS);
+			glEnable(GL_COLOR_LOGIC_OP);
+			glLogicOp(GL_XOR);
+			flushHud(state, true);
+			glDisable(GL_COLOR_LOGIC_OP);
+
+			glEnable(GL_DEPTH_TEST);
+		}
     }
 }
 
-int main(void)
+struct Alloc_test
+{
+	bool enabled;
+	int frames;
+	int settled_frames;
+	int measured_frames;
+	int failed_frames;
+	bool done;
+};
+
+// NOTE: runs after PROFILE_END_FRAME, so last_counters belong to the frame that just ended.
+// The call sites of the first frame that allocates go into ALLOC_TEST_REPORT.
+void alloc_test_end_frame(Alloc_test *test, Game_state *state) {
+	const int64_t *counters = global_profiler.last_counters;
+	test->frames++;
+
+	if (test->settled_frames < ALLOC_TEST_SETTLE_FRAMES)
+	{
+		bool idle = counters[PROFILER_COUNTER_CHUNKS_GENERATED] == 0 && counters[PROFILER_COUNTER_CHUNKS_REBUILT] == 0 && state->world.rebuild_stack.empty();
+		test->settled_frames = idle ? test->settled_frames + 1 : 0;
+		if (test->settled_frames == ALLOC_TEST_SETTLE_FRAMES)
+			alloc_tracker_clear_sites();
+
+		if (test->frames >= ALLOC_TEST_TIMEOUT_FRAMES)
+		{
+			std::cout << "Alloc test: the world didn't settle in " << ALLOC_TEST_TIMEOUT_FRAMES << " frames" << std::endl;
+			test->failed_frames = 1;
+			test->done = true;
+		}
+		return;
+	}
+
+	if (counters[PROFILER_COUNTER_ALLOCATIONS] != 0)
+	{
+		if (test->failed_frames++ == 0)
+		{
+			std::cout << "Alloc test: frame " << test->measured_frames << " made " << counters[PROFILER_COUNTER_ALLOCATIONS]
+				<< " allocations, call sites written to " << ALLOC_TEST_REPORT << std::endl;
+
+			FILE *f = fopen(ALLOC_TEST_REPORT, "w");
+			if (f)
+			{
+				alloc_tracker_write_sites(f);
+				fclose(f);
+			}
+		}
+	}
+	else
+	{
+		alloc_tracker_clear_sites();
+	}
+
+	if (++test->measured_frames == ALLOC_TEST_FRAMES)
+	{
+		std::cout << "Alloc test: " << test->failed_frames << " of " << ALLOC_TEST_FRAMES << " frames allocated" << std::endl;
+		test->done = true;
+	}
+}
+
+int main(int argc, char **argv)
 {
     if (glfwInit() == GLFW_FALSE)
     {
@@ -1214,21 +2276,57 @@ int main(void)
         return (-1);
     }
     glfwSwapInterval(1);
+    gl_counters_install();
 
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
 	static uint8_t game_state_mem_blob[sizeof(Game_state)];
     static uint8_t transient_mem_blob[TRANSIENT_MEM_SIZE];
-	static Chunk chunk_mem_blob[MAX_CHUNKS];
 	
     Game_memory game_memory = {};
     game_memory.transient_mem_size = TRANSIENT_MEM_SIZE;
     game_memory.transient_mem = transient_mem_blob;
+    {
+        uint8_t *scratch_mem = transient_mem_blob + TRANSIENT_MEM_SIZE - SCRATCH_ARENA_COUNT * SCRATCH_ARENA_SIZE;
+        arena_init(&game_memory.frame_arena, "frame", transient_mem_blob, scratch_mem - transient_mem_blob);
+        for (int i = 0; i < SCRATCH_ARENA_COUNT; i++)
+        {
+            arena_init(&game_memory.scratch_arenas[i], "scratch", scratch_mem + i * SCRATCH_ARENA_SIZE, SCRATCH_ARENA_SIZE);
+        }
+    }
 	game_memory.game_state = (Game_state*) game_state_mem_blob;
-	game_memory.chunkAllocator = new PoolAllocator<Chunk>(chunk_mem_blob, MAX_CHUNKS);
+	game_memory.chunkAllocator = new PoolAllocator<Chunk>(CHUNK_POOL_PAGE_CHUNKS, CHUNK_POOL_MAX_PAGES);
 
     game_state_and_memory_init(&game_memory);
 
+    alloc_tracker_attach_thread();
+
+    // NOTE: --trace captures from the first frame until F6 or exit,
+    // --slow-frame-ms sets the frame time that makes the flight recorder dump its frames,
+    // --alloc-test ignores the input and exits with 1 if a steady state frame allocates
+    Alloc_test alloc_test = {};
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--trace") == 0)
+        {
+            trace_start();
+        }
+        else if (strcmp(argv[i], "--slow-frame-ms") == 0 && i + 1 < argc)
+        {
+            global_flight_recorder.threshold_ms = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--alloc-test") == 0)
+        {
+#if ALLOC_TRACKING_ENABLED
+            alloc_test.enabled = true;
+#else
+            std::cout << "--alloc-test needs a build with ALLOC_TRACKING_ENABLED" << std::endl;
+            glfwTerminate();
+            return (1);
+#endif
+        }
+    }
+
     Game_input inputs[2] = {};
     Game_input *game_input = &inputs[0];
     Game_input *prev_game_input = &inputs[1];
@@ -1325,21 +2423,74 @@ int main(void)
         {
             game_input->n4.is_pressed = 1;
         }
+        if (glfwGetKey(window, GLFW_KEY_F1) == GLFW_PRESS)
+        {
+            game_input->f1.is_pressed = 1;
+        }
+        if (glfwGetKey(window, GLFW_KEY_F2) == GLFW_PRESS)
+        {
+            game_input->f2.is_pressed = 1;
+        }
+        if (glfwGetKey(window, GLFW_KEY_F3) == GLFW_PRESS)
+        {
+            game_input->f3.is_pressed = 1;
+        }
+        if (glfwGetKey(window, GLFW_KEY_F4) == GLFW_PRESS)
+        {
+            game_input->f4.is_pressed = 1;
+        }
+        if (glfwGetKey(window, GLFW_KEY_F5) == GLFW_PRESS)
+        {
+            game_input->f5.is_pressed = 1;
+        }
+        if (glfwGetKey(window, GLFW_KEY_F6) == GLFW_PRESS)
+        {
+            game_input->f6.is_pressed = 1;
+        }
+        if (glfwGetKey(window, GLFW_KEY_F7) == GLFW_PRESS)
+        {
+            game_input->f7.is_pressed = 1;
+        }
+
+        // NOTE: the camera stays where it spawned
+        if (alloc_test.enabled)
+        {
+            for (int i = 0; i < num_of_buttons; i++)
+            {
+                game_input->buttons[i] = {};
+            }
+            game_input->mouse_dx = 0.0f;
+            game_input->mouse_dy = 0.0f;
+        }
 
         game_update_and_render(game_input, &game_memory);
 
         prev_time = curr_time;
         curr_time = glfwGetTime();
 
-        glfwSwapBuffers(window);
+        {
+            PROFILE_SCOPE("Swap");
+            glfwSwapBuffers(window);
+        }
         glfwPollEvents();
+        PROFILE_END_FRAME();
+        GPU_PROFILE_END_FRAME();
+
+        if (alloc_test.enabled)
+        {
+            alloc_test_end_frame(&alloc_test, state);
+            if (alloc_test.done)
+                break;
+        }
 
         Game_input *temp_input = game_input;
         game_input = prev_game_input;
         prev_game_input = temp_input;
     }
 
+    gpu_profiler_close_csv();
+    trace_stop();
     glfwDestroyWindow(window);
     glfwTerminate();
-    return (0);
+    return (alloc_test.failed_frames > 0) ? 1 : 0;
 }
@@ -6,9 +6,21 @@
 #include "ShaderProgram.h"
 #include "Skybox.h"
 #include "ShadowMap.h"
+#include "FarTerrain.h"
+#include "HeightmapShadow.h"
+#include "HudBatch.h"
+#include "HudLayer.h"
+#include "Profiler.h"
+#include "GpuProfiler.h"
+#include "FlightRecorder.h"
+#include "GlCounters.h"
+#include "AllocTracker.h"
+#include "MemoryArena.h"
 #include "PoolAllocator.hpp"
 #include "Chunk.h"
 #include "World.h"
+#include "Mesher.h"
+#include "Terrain.h"
 
 #define MEMORY_KB(x) ((x) * 1024ull)
 #define MEMORY_MB(x) MEMORY_KB((x) * 1024ull)
@@ -17,26 +29,43 @@
 #define ALIGN_UP(n, k) (((n) + (k) - 1) & ((~(k)) + 1))
 #define ALIGN_PTR_UP(n, k) ALIGN_UP((uint64_t)(n), (k))
 
-#define MAX_CHUNKS 20480
+// NOTE: the chunk pool grows a page at a time, up to CHUNK_POOL_MAX_PAGES * CHUNK_POOL_PAGE_CHUNKS chunks
+#define CHUNK_POOL_PAGE_CHUNKS 1024
+#define CHUNK_POOL_MAX_PAGES 64
 #define TRANSIENT_MEM_SIZE MEMORY_GB(1)
+#define SCRATCH_ARENA_COUNT 4 // NOTE: threads that can hold a scratch arena at once
+#define SCRATCH_ARENA_SIZE MEMORY_MB(64)
 
 #define TIME_SPEED 0.001
 #define WORLD_RADIUS 8
 #define GENERATION_Y_RADIUS 4
-#define WORLD_SEED 0x7b447dc7
 
-struct Range3d
-{
-    uint8_t type;
-
-    int start_x;
-    int start_y;
-    int start_z;
-
-    int end_x;
-    int end_y;
-    int end_z;
-};
+// NOTE: chunks further than this many chunks away are meshed at LOD 1 and LOD 2
+#define LOD_1_DISTANCE 3
+#define LOD_2_DISTANCE 5
+#define LOD_REBUILDS_PER_FRAME 16
+
+// NOTE: far terrain dissolves between these distances in blocks, where the loaded chunks still cover it
+#define FAR_TERRAIN_FADE_START ((WORLD_RADIUS - 2) * CHUNK_DIM)
+#define FAR_TERRAIN_FADE_END (WORLD_RADIUS * CHUNK_DIM)
+#define FAR_TERRAIN_NEAR 16.0f
+
+#define OCCLUSION_BOX_MARGIN 0.5f
+#define HORIZON_BINS 1024
+
+#define EDIT_CACHE_SIZE 8
+#define EDIT_FACE_HEADROOM_VS (64 * VERTICES_PER_FACE)
+#define EDIT_SHADOW_REBUILD_FRAMES 30
+#define SHADOW_QUALITY_COUNT 4
+#define SHADOW_QUALITY_DEFAULT 2
+#define GPU_TIMINGS_CSV "gpu_timings.csv"
+
+// NOTE: --alloc-test waits until nothing was generated or rebuilt for ALLOC_TEST_SETTLE_FRAMES frames,
+// then expects ALLOC_TEST_FRAMES frames without heap allocations
+#define ALLOC_TEST_SETTLE_FRAMES 120
+#define ALLOC_TEST_FRAMES 600
+#define ALLOC_TEST_TIMEOUT_FRAMES 20000
+#define ALLOC_TEST_REPORT "alloc_test.txt"
 
 struct Button
 {
@@ -74,12 +103,50 @@ struct Game_input
             Button n2;
             Button n3;
             Button n4;
+
+            Button f1;
+            Button f2;
+            Button f3;
+            Button f4;
+            Button f5;
+            Button f6;
+            Button f7;
         };
 
-        Button buttons[13];
+        Button buttons[20];
     };
 };
 
+struct Mesh_range
+{
+	Range3d range;
+	int first_v[FACE_COUNT]; // NOTE: slot of every face in the face group of the mesh, -1 when it has none
+};
+
+// NOTE: ranges of a recently edited chunk, kept so that block edits
+// can be patched into its meshes without remeshing the whole chunk
+struct Chunk_edit_cache
+{
+	Chunk *chunk;
+	int nranges;
+	Mesh_range ranges[BLOCKS_IN_CHUNK];
+	uint64_t last_used;
+	// NOTE: patched edits leave the shadow mesh behind, it is remeshed once the chunk isn't edited
+	// for a frame or every EDIT_SHADOW_REBUILD_FRAMES frames while it is
+	bool shadow_dirty;
+	uint64_t shadow_built;
+};
+
+// NOTE: shadow map size, number of shadow map cascades and
+// shadow map lookups per fragment, switched at runtime
+struct Shadow_quality
+{
+	const char *name;
+	int resolution;
+	int cascades;
+	int taps;
+};
+
 struct Game_state
 {
 	PoolAllocator<Chunk> *chunkAllocator;
@@ -87,15 +154,19 @@ struct Game_state
 	Skybox skybox;
     ShaderProgram skyboxSP;
 	ShaderProgram sunSP;
-	ShaderProgram imageSP;
-	ShaderProgram inventoryBlockSP;
 	ShaderProgram mesh_sp;
 	ShaderProgram meshShadowMapSP;
-	ShaderProgram fontCharacterSP;
+	ShaderProgram hudSP;
+	ShaderProgram farTerrainSP;
+	ShaderProgram depthPrepassSP;
 	ShadowMap shadowMap1;
 	ShadowMap shadowMap2;
 	ShadowMap shadowMap3;
 	ShadowMap shadowMap4;
+	FarTerrain farTerrain;
+	HeightmapShadow heightmapShadow;
+	HudBatch hud;
+	HudLayer hudLayer;
 	Texture sunTexture;
 	Texture inventoryBarTexture;
 	Texture crossTexture;
@@ -112,12 +183,23 @@ struct Game_state
     Vec3f cam_rot;
 
     uint8_t block_to_place;
+	bool depthPrepass;
+	bool heightmapShadows; // NOTE: heightmap shadows instead of the farthest shadow cascade
+	int shadowQuality;
+	bool profilerOverlay;
+	int memoryDumps;
 
 	int frameCount;
 	float fpsCounterPrevTime;
 	float fps;
 
+	// NOTE: what the cached HUD layer was last drawn with
+	int hudFps;
+	int hudBlockToPlace;
+	int hudShadowQuality;
+
     World world;
+	Chunk_edit_cache edit_caches[EDIT_CACHE_SIZE];
 };
 
 struct Game_memory
@@ -126,11 +208,17 @@ struct Game_memory
 
     uint64_t transient_mem_size;
     void *transient_mem;
+	// NOTE: split out of transient_mem, the frame arena is emptied at the start of every frame,
+	// scratch arenas are for work that is done before the function returns, one per thread
+	Memory_arena frame_arena;
+	Memory_arena scratch_arenas[SCRATCH_ARENA_COUNT];
 
 	Game_state *game_state;
 
 	Range3d ranges[BLOCKS_IN_CHUNK];
-	uint8_t visited[BLOCKS_IN_CHUNK];
+	Chunk_masks masks;
+	uint8_t lod_blocks[BLOCKS_IN_CHUNK];
+	uint8_t solid_blocks[BLOCKS_IN_CHUNK];
 	PoolAllocator<Chunk> *chunkAllocator;
 };
 
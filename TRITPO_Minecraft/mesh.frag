@@ -15,10 +15,16 @@ uniform vec3 light_pos;
 uniform float ambient_factor;
 uniform float diffuse_strength;
 uniform float shadowStrength;
-uniform sampler2D depthMap1;
-uniform sampler2D depthMap2;
-uniform sampler2D depthMap3;
-uniform sampler2D depthMap4;
+uniform sampler2DShadow depthMap1;
+uniform sampler2DShadow depthMap2;
+uniform sampler2DShadow depthMap3;
+uniform sampler2DShadow depthMap4;
+uniform int shadowCascades;
+uniform int shadowTaps;
+uniform sampler2D occludedHeights;
+uniform bool heightmapShadows;
+uniform vec2 heightmapOrigin;
+uniform float heightmapSize;
 
 bool isInShadowMap(vec4 posLightSpace) {
 	vec3 projCoords = posLightSpace.xyz / posLightSpace.w;
@@ -27,28 +33,46 @@ bool isInShadowMap(vec4 posLightSpace) {
 	return projCoords.x >= 0.005 && projCoords.y >= 0.005 && projCoords.x <= 0.995 && projCoords.y <= 0.995;
 }
 
-float getShadow(vec4 posLightSpace, sampler2D depthMap) {
+// NOTE: every lookup returns the filtered result of 2x2 depth comparisons
+float getShadow(vec4 posLightSpace, sampler2DShadow depthMap) {
 	vec3 projCoords = posLightSpace.xyz / posLightSpace.w;
 	projCoords = projCoords * 0.5 + 0.5;
-	float currentDepth = projCoords.z;
-	float shadow = 0.0;
+	float currentDepth = projCoords.z - 0.001;
+	float lit = 0.0;
 	
 	vec2 texelSize = 1.0 / textureSize(depthMap, 0);
 
-	if (shadowStrength > 0.99f) {
+	if (shadowStrength > 0.99f && shadowTaps >= 9) {
 		for (int i = -1; i <=1; ++i) {
 			for (int j = -1; j <=1; ++j) {
-				float depth = texture(depthMap, projCoords.xy + vec2(i, j) * texelSize).r;
-				shadow += currentDepth - 0.001 > depth ? 1.0 / 9.0 : 0.0;
+				lit += texture(depthMap, vec3(projCoords.xy + vec2(i, j) * texelSize, currentDepth)) / 9.0;
 			}
 		}	
 	}
+	else if (shadowStrength > 0.99f && shadowTaps >= 4) {
+		for (int i = 0; i < 2; ++i) {
+			for (int j = 0; j < 2; ++j) {
+				lit += texture(depthMap, vec3(projCoords.xy + (vec2(i, j) - 0.5) * texelSize, currentDepth)) / 4.0;
+			}
+		}
+	}
 	else {
-		float depth = texture(depthMap, projCoords.xy).r;
-		shadow += currentDepth - 0.001 > depth ? 1.0 : 0.0;
+		lit = texture(depthMap, vec3(projCoords.xy, currentDepth));
 	}
 
-	return shadow * shadowStrength;
+	return (1.0 - lit) * shadowStrength;
+}
+
+float getHeightmapShadow() {
+	// NOTE: step off the face so that side faces read the column in front of them
+	vec2 column = floor(world_pos.xz + normal.xz * 0.5);
+	vec2 rel = column - heightmapOrigin;
+
+	if (rel.x < 0.0 || rel.y < 0.0 || rel.x >= heightmapSize || rel.y >= heightmapSize)
+		return 0.0;
+
+	float occluded = texelFetch(occludedHeights, ivec2(mod(column, heightmapSize)), 0).r;
+	return (world_pos.y + 0.01 < occluded ? 1.0 : 0.0) * shadowStrength;
 }
 
 void main() {
@@ -58,12 +82,16 @@ void main() {
 	
 	if (isInShadowMap(posLightSpace1))
 		shadow = getShadow(posLightSpace1, depthMap1);
-	else if (isInShadowMap(posLightSpace2))
+	else if (shadowCascades > 1 && isInShadowMap(posLightSpace2))
 		shadow = getShadow(posLightSpace2, depthMap2);
-	else if (isInShadowMap(posLightSpace3))
+	else if (shadowCascades > 2 && isInShadowMap(posLightSpace3))
 		shadow = getShadow(posLightSpace3, depthMap3);
-	else
+	else if (heightmapShadows)
+		shadow = getHeightmapShadow();
+	else if (shadowCascades > 3)
 		shadow = getShadow(posLightSpace4, depthMap4);
+	else
+		shadow = 0.0;
 
 	vec3 light = light_col * clamp(ambient_factor + diffuse_factor * diffuse_strength * (1 - shadow), 0.0f, 1.0f);
 
@@ -18,6 +18,8 @@ out vec4 posLightSpace2;
 out vec4 posLightSpace3;
 out vec4 posLightSpace4;
 
+invariant gl_Position; // NOTE: has to match depthPrepass.vert for GL_EQUAL depth
+
 
 void main() {
 	gl_Position = u_projection * u_view * u_model * vec4(aVertexPos, 1.0f);
@@ -1,456 +1,468 @@
+// Mesher benchmark and differential tester.
+//
+// Runs every mesher variant of the game over a corpus of real (terrain generator) and
+// synthetic chunks, checks that every variant covers exactly the solid voxels of the chunk
+// without dropping exposed faces, checks that the variants that promise it find the same
+// boxes as greedy, and reports ranges, triangles and time per chunk.
+//
+// usage: mesher [repetitions]
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
 #include <assert.h>
+#include <chrono>
 
-struct Range1d
+// NOTE: the mesher is built from the same sources as the game
+#include "../TRITPO_Minecraft/3DMath.cpp"
+#include "../TRITPO_Minecraft/Blocks.cpp"
+#include "../TRITPO_Minecraft/Terrain.cpp"
+#include "../TRITPO_Minecraft/Mesher.cpp"
+
+#define DIM 16
+#define BLOCKS_IN_CHUNK (DIM * DIM * DIM)
+#define MAX_CHUNKS_IN_SET 1024
+
+struct Test_chunk
 {
-    int type;
-    int start;
-    int end;
+    uint8_t blocks[BLOCKS_IN_CHUNK];
+    int nblocks;
 };
 
-struct Range2d
+struct Chunk_set
 {
-    int start_x;
-    int start_y;
-    int end_x;
-    int end_y;
+    const char *name;
+    int count;
+    Test_chunk *chunks;
 };
 
-struct Range3d
+typedef int Mesher_proc(uint8_t *blocks, int nblocks, Range3d *ranges);
+
+struct Mesher_variant
 {
-    uint8_t type;
-
-    int start_x;
-    int start_y;
-    int start_z;
-    
-    int end_x;
-    int end_y;
-    int end_z;
+    const char *name;
+    Mesher_proc *proc;
+    bool greedy_boxes; // NOTE: has to find the same boxes as gen_ranges_3d
 };
 
-void mesh_1d(int *blocks, int width, int count, Range1d *ranges, int *num_of_ranges)
+static uint8_t visited[BLOCKS_IN_CHUNK];
+static Chunk_masks masks;
+
+int mesh_naive(uint8_t *blocks, int, Range3d *ranges)
 {
+    int nranges = 0;
+    gen_ranges_naive(blocks, ranges, DIM, &nranges);
 
-    int *visited = (int *)calloc(width, sizeof(int));
-    int ranges_count = 0;
-    while (count > 0)
-    {
-        int start = 0;
-        int end = 0;
-        for (start = 0; start < width; start++)
-        {
-            if (visited[start] == 0)
-            {
-                break;
-            }
-        }
+    return (nranges);
+}
 
-        while (start < width && blocks[start] == 0)
-        {
-            visited[start] = 1;
-            start++;
-        }
+int mesh_greedy(uint8_t *blocks, int nblocks, Range3d *ranges)
+{
+    // NOTE: clearing visited is part of the cost in the game as well
+    memset(visited, 0, sizeof(visited));
 
-        int block_type = 0;
-        if (start < width)
-        {
-            visited[start] = 1;
-            count--;
+    int nranges = 0;
+    gen_ranges_3d(blocks, ranges, visited, DIM, nblocks, &nranges);
 
-            block_type = blocks[start];
-        }
+    return (nranges);
+}
 
-        end = start;
-        while ((end + 1 < width) && (blocks[end + 1] == block_type))
-        {
-            visited[end + 1] = 1;
-            end++;
-            count--;
-        }
+int mesh_bitmask(uint8_t *blocks, int, Range3d *ranges)
+{
+    int nranges = 0;
+    gen_ranges_bitmask(blocks, ranges, &masks, &nranges);
 
-        ranges[ranges_count++] = { block_type, start, end };
-    }
+    // NOTE: the game groups ranges by type before building meshes
+    sort_ranges_by_type(ranges, nranges);
 
-    *num_of_ranges = ranges_count;
-    free(visited);
+    return (nranges);
 }
 
-void mesh_2d(int *blocks, int width, int height, int count, Range2d *ranges, int *num_of_ranges)
+Mesher_variant variants[] =
 {
-    int *visited = (int *)calloc(width * height, sizeof(int));
-    int ranges_count = 0;
+    { "naive",   mesh_naive,   false },
+    { "greedy",  mesh_greedy,  false },
+    { "bitmask", mesh_bitmask, true },
+};
 
-    while (count > 0)
-    {
-        int start_y = 0;
-        int end_y   = 0;
+//
+// corpus
+//
 
-        int start_x = 0;
-        int end_x   = 0;
+static uint32_t rng_state = 0x12345678;
 
-        // skip all visited and empty blocks
-        for (start_y = 0; start_y < height; start_y++)
-        {
-            for (start_x = 0; start_x < width; start_x++)
-            {
-                if (visited[start_y * width + start_x] == 0 &&
-                    blocks[start_y * width + start_x] != 0)
-                {
-                    goto break1;
-                }
-            }
-        }
-break1:
+uint32_t rng_next(void)
+{
+    // xorshift32
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return (rng_state);
+}
 
-        // if a block at start_x, start_y is in the grid (the grid is not empty),
-        // mark it as visited
-        if (start_x < width && start_y < height)
-        {
-            visited[start_y * width + start_x] = 1;
-            count--;
-        }
+Test_chunk *push_chunk(Chunk_set *set)
+{
+    assert(set->count < MAX_CHUNKS_IN_SET);
+    Test_chunk *c = &set->chunks[set->count++];
+    memset(c->blocks, BLOCK_AIR, sizeof(c->blocks));
+    c->nblocks = 0;
 
-        // try expand in x direction
-        end_x = start_x;
-        while ( (end_x + 1 < width) &&
-                (blocks[start_y * width + (end_x + 1)] != 0) &&
-                (visited[start_y * width + (end_x + 1)] == 0))
-        {
-            visited[start_y * width + (end_x + 1)] = 1;
-            end_x++;
-            count--;
-        }
+    return (c);
+}
 
-        // try expand in y direction
-        end_y = start_y;
+void set_block(Test_chunk *c, int x, int y, int z, uint8_t type)
+{
+    c->blocks[DIM * DIM * y + DIM * z + x] = type;
+    c->nblocks++;
+}
 
-        while (end_y + 1 < height)
+void make_terrain_set(Chunk_set *set)
+{
+    for (int chunk_x = -4; chunk_x < 4; chunk_x++)
+    {
+        for (int chunk_z = -4; chunk_z < 4; chunk_z++)
         {
-            bool can_expand = true;
-            for (int x = start_x; x <= end_x; x++)
+            for (int chunk_y = 0; chunk_y < 12; chunk_y++)
             {
-                if (blocks[(end_y + 1) * width + x] == 0 ||
-                    visited[(end_y + 1) * width + x] == 1)
+                Test_chunk *c = push_chunk(set);
+                c->nblocks = generate_chunk_blocks(c->blocks, DIM, chunk_x, chunk_y, chunk_z);
+            }
+        }
+    }
+}
+
+void make_checkerboard_set(Chunk_set *set)
+{
+    // single type, every other voxel solid: worst case for greedy meshing
+    Test_chunk *c = push_chunk(set);
+    for (int y = 0; y < DIM; y++)
+        for (int z = 0; z < DIM; z++)
+            for (int x = 0; x < DIM; x++)
+                if ((x + y + z) & 1) set_block(c, x, y, z, BLOCK_STONE);
+
+    // fully solid, two types alternating
+    c = push_chunk(set);
+    for (int y = 0; y < DIM; y++)
+        for (int z = 0; z < DIM; z++)
+            for (int x = 0; x < DIM; x++)
+                set_block(c, x, y, z, ((x + y + z) & 1) ? BLOCK_STONE : BLOCK_DIRT);
+
+    // 2x2x2 cells
+    c = push_chunk(set);
+    for (int y = 0; y < DIM; y++)
+        for (int z = 0; z < DIM; z++)
+            for (int x = 0; x < DIM; x++)
+                if (((x >> 1) + (y >> 1) + (z >> 1)) & 1) set_block(c, x, y, z, BLOCK_GRASS);
+
+    // stripes along every axis
+    for (int axis = 0; axis < 3; axis++)
+    {
+        c = push_chunk(set);
+        for (int y = 0; y < DIM; y++)
+            for (int z = 0; z < DIM; z++)
+                for (int x = 0; x < DIM; x++)
                 {
-                    can_expand = false;
-                    break;
+                    int v = (axis == 0) ? x : ((axis == 1) ? y : z);
+                    if (v & 1) set_block(c, x, y, z, BLOCK_SNOW);
                 }
-            }
+    }
+}
 
-            if (can_expand)
+void make_random_set(Chunk_set *set)
+{
+    int densities[] = { 5, 25, 50, 75, 95 };
+
+    for (int d = 0; d < (int)(sizeof(densities) / sizeof(densities[0])); d++)
+    {
+        for (int i = 0; i < 32; i++)
+        {
+            Test_chunk *c = push_chunk(set);
+            for (int idx = 0; idx < BLOCKS_IN_CHUNK; idx++)
             {
-                // mark expanded row of block as visited
-                for (int x = start_x; x <= end_x; x++)
+                if ((int)(rng_next() % 100) < densities[d])
                 {
-                    visited[(end_y + 1) * width + x] = 1;
+                    c->blocks[idx] = (uint8_t)(rng_next() % BLOCK_TYPE_COUNT);
+                    c->nblocks++;
                 }
-                end_y++;
-                count -= end_x - start_x + 1;
-            }
-            else
-            {
-                break;
             }
         }
+    }
+}
 
-        ranges[ranges_count++] = {start_x, start_y, end_x, end_y};
+void make_edge_case_set(Chunk_set *set)
+{
+    // empty
+    push_chunk(set);
+
+    // full
+    Test_chunk *c = push_chunk(set);
+    for (int y = 0; y < DIM; y++)
+        for (int z = 0; z < DIM; z++)
+            for (int x = 0; x < DIM; x++)
+                set_block(c, x, y, z, BLOCK_STONE);
+
+    // single block in every corner
+    for (int corner = 0; corner < 8; corner++)
+    {
+        c = push_chunk(set);
+        set_block(c, (corner & 1) ? DIM - 1 : 0, (corner & 2) ? DIM - 1 : 0, (corner & 4) ? DIM - 1 : 0, BLOCK_DIRT);
     }
 
-    *num_of_ranges = ranges_count;
-    free(visited);
+    // every block type in one column
+    c = push_chunk(set);
+    for (int y = 0; y < DIM; y++)
+        set_block(c, 7, y, 7, (uint8_t)(y % BLOCK_TYPE_COUNT));
 }
 
-void mesh_3d(uint8_t *blocks, int dim, int count, Range3d *ranges, int *num_of_ranges)
-{
-    int *visited = (int *)calloc(dim * dim * dim, sizeof(int));
-    int ranges_count = 0;
+//
+// verification
+//
 
-    while (count > 0)
+bool is_solid(Test_chunk *c, int x, int y, int z)
+{
+    if (x < 0 || y < 0 || z < 0 || x >= DIM || y >= DIM || z >= DIM)
     {
-        int start_z = 0;
-        int end_z = 0;
-
-        int start_y = 0;
-        int end_y = 0;
+        return (false);
+    }
 
-        int start_x = 0;
-        int end_x = 0;
+    return (c->blocks[DIM * DIM * y + DIM * z + x] != BLOCK_AIR);
+}
 
-        // skip all visited and empty blocks
-        for (start_y = 0; start_y < dim; start_y++)
-        {
-            for (start_z = 0; start_z < dim; start_z++)
-            {
-                for (start_x = 0; start_x < dim; start_x++)
-                {
-                    // TODO(max): think about it
-                    if (visited[start_y * dim * dim + start_z * dim + start_x] == 0 &&
-                        blocks[start_y * dim * dim + start_z * dim + start_x] != 0)
-                    {
-                        goto break1;
-                    }
-                }
-            }
-        }
-    break1:
+// NOTE: returns 0 if the ranges cover every solid voxel exactly once with its own type
+// and cover no air, and no face with an exposed voxel on it was dropped,
+// otherwise prints the first error and returns 1
+int verify_ranges(Test_chunk *c, Range3d *ranges, int nranges)
+{
+    int face_dirs[FACE_COUNT][3] = {
+        { 0, -1, 0 }, { 0, 1, 0 }, { 0, 0, -1 }, { 0, 0, 1 }, { -1, 0, 0 }, { 1, 0, 0 },
+    };
 
-        // If a block at (start_x, start_y, start_z) is in the grid (the grid is not empty), mark it as visited.
-        // Also record block type.
-        uint8_t block_type = 0;
-        if (start_x < dim && start_y < dim && start_z < dim)
-        {
-            visited[start_y * dim * dim + start_z * dim + start_x] = 1;
-            block_type = blocks[start_y * dim * dim + start_z * dim + start_x];
-            count--;
-        }
+    static uint8_t covered[BLOCKS_IN_CHUNK];
+    memset(covered, 0, sizeof(covered));
 
-        // try expand in x direction
-        end_x = start_x;
-        while ((end_x + 1 < dim) &&
-            (blocks[start_y * dim * dim + start_z * dim + (end_x + 1)] == block_type) &&
-            (visited[start_y * dim * dim + start_z * dim + (end_x + 1)] == 0))
-        {
-            visited[start_y * dim * dim + start_z * dim + (end_x + 1)] = 1;
-            end_x++;
-            count--;
-        }
+    for (int i = 0; i < nranges; i++)
+    {
+        Range3d *r = &ranges[i];
 
-        // try expand in z direction
-        end_z = start_z;
-        while (end_z + 1 < dim)
+        if (r->type >= BLOCK_TYPE_COUNT ||
+            r->start_x < 0 || r->start_y < 0 || r->start_z < 0 ||
+            r->end_x >= DIM || r->end_y >= DIM || r->end_z >= DIM ||
+            r->start_x > r->end_x || r->start_y > r->end_y || r->start_z > r->end_z)
         {
-            bool can_expand = true;
-            for (int x = start_x; x <= end_x; x++)
-            {
-                if (blocks[start_y * dim * dim + (end_z + 1) * dim + x] != block_type ||
-                    visited[start_y * dim * dim + (end_z + 1) * dim + x] == 1)
-                {
-                    can_expand = false;
-                    break;
-                }
-            }
-
-            if (can_expand)
-            {
-                // mark expanded row of block as visited
-                for (int x = start_x; x <= end_x; x++)
-                {
-                    visited[start_y * dim * dim + (end_z + 1) * dim + x] = 1;
-                }
-                end_z++;
-                count -= end_x - start_x + 1;
-            }
-            else
-            {
-                break;
-            }
+            printf("\trange %d is malformed: type %d (%d, %d, %d) (%d, %d, %d)\n", i, r->type,
+                r->start_x, r->start_y, r->start_z, r->end_x, r->end_y, r->end_z);
+            return (1);
         }
 
-        // try expand in y direction
-        end_y = start_y;
-        while (end_y + 1 < dim)
+        for (int y = r->start_y; y <= r->end_y; y++)
         {
-            bool can_expand = true;
-            for (int z = start_z; z <= end_z; z++)
+            for (int z = r->start_z; z <= r->end_z; z++)
             {
-                for (int x = start_x; x <= end_x; x++)
+                for (int x = r->start_x; x <= r->end_x; x++)
                 {
-                    if (blocks[(end_y + 1) * dim * dim + z * dim + x] != block_type ||
-                        visited[(end_y + 1) * dim * dim + z * dim + x] == 1)
+                    int idx = DIM * DIM * y + DIM * z + x;
+                    if (c->blocks[idx] != r->type)
                     {
-                        can_expand = false;
-                        goto break2;
+                        printf("\trange %d covers (%d, %d, %d) of type %d with type %d\n", i, x, y, z, c->blocks[idx], r->type);
+                        return (1);
                     }
-                }
-            }
-        break2:
-            if (can_expand)
-            {
-                for (int z = start_z; z <= end_z; z++)
-                {
-                    for (int x = start_x; x <= end_x; x++)
+                    if (covered[idx])
                     {
-                        visited[(end_y + 1) * dim * dim + z * dim + x] = 1;
+                        printf("\trange %d covers (%d, %d, %d) twice\n", i, x, y, z);
+                        return (1);
+                    }
+                    covered[idx] = 1;
+
+                    for (int f = 0; f < FACE_COUNT; f++)
+                    {
+                        if (r->faces & (1 << f)) continue;
+
+                        int nx = x + face_dirs[f][0];
+                        int ny = y + face_dirs[f][1];
+                        int nz = z + face_dirs[f][2];
+                        bool on_face = nx < r->start_x || ny < r->start_y || nz < r->start_z ||
+                                       nx > r->end_x || ny > r->end_y || nz > r->end_z;
+                        if (on_face && !is_solid(c, nx, ny, nz))
+                        {
+                            printf("\trange %d dropped face %d with exposed voxel (%d, %d, %d)\n", i, f, x, y, z);
+                            return (1);
+                        }
                     }
                 }
-                end_y++;
-                count -= (end_x - start_x + 1) * (end_z - start_z + 1);
-            }
-            else
-            {
-                break;
             }
         }
+    }
 
-        ranges[ranges_count++] = { block_type, start_x, start_y, start_z, end_x, end_y, end_z};
+    for (int idx = 0; idx < BLOCKS_IN_CHUNK; idx++)
+    {
+        if (c->blocks[idx] != BLOCK_AIR && !covered[idx])
+        {
+            printf("\tsolid voxel (%d, %d, %d) is not covered\n", idx % DIM, idx / (DIM * DIM), (idx / DIM) % DIM);
+            return (1);
+        }
     }
 
-    assert(count == 0);
-    free(visited);
-    *num_of_ranges = ranges_count;
+    return (0);
 }
 
-void test_1d_meshing(void)
-{
-    const int width1 = 16;
-    int blocks1[width1] = {
-        1, 1, 1, 1,  0, 0,  2, 2, 2,  0,  1,  2,  1, 0, 3, 3
-    };
-
-    const int width2 = 16;
-    int blocks2[width2] = {
-        1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0,
-    };
+static Range3d greedy_ranges[BLOCKS_IN_CHUNK];
+static int greedy_box[BLOCKS_IN_CHUNK];
 
-    const int width3 = 16;
-    int blocks3[width3] = {
-        1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 1, 1, 1, 1, 1,
-    };
-
-    const int width4 = 4;
-    int blocks4[width4] = {
-        0, 1, 1, 0,
-    };
-
-    int width   = width1;
-    int *blocks = blocks1;
-
-    int count = 0;
-    for (int i = 0; i < width; i++)
+// NOTE: returns 0 if the ranges are the boxes gen_ranges_3d finds, in any order, otherwise prints
+// the first difference and returns 1. Both cover every solid voxel exactly once, so every range
+// having a twin among as many greedy ranges makes the two sets equal.
+int compare_with_greedy(Test_chunk *c, Range3d *ranges, int nranges)
+{
+    int ngreedy = mesh_greedy(c->blocks, c->nblocks, greedy_ranges);
+    if (ngreedy != nranges)
     {
-        if (blocks[i]) count++;
+        printf("	%d ranges, greedy finds %d\n", nranges, ngreedy);
+        return (1);
     }
 
-    int ranges_count = 0;
-    Range1d *ranges = (Range1d *)calloc(width / 2 + 1, sizeof(Range1d));
-
-    mesh_1d(blocks, width, count, ranges, &ranges_count);
+    for (int i = 0; i < ngreedy; i++)
+    {
+        Range3d *g = &greedy_ranges[i];
+        for (int y = g->start_y; y <= g->end_y; y++)
+            for (int z = g->start_z; z <= g->end_z; z++)
+                for (int x = g->start_x; x <= g->end_x; x++)
+                    greedy_box[DIM * DIM * y + DIM * z + x] = i;
+    }
 
-    if (ranges_count > 0)
+    for (int i = 0; i < nranges; i++)
     {
-        for (int i = 0; i < ranges_count; i++)
+        Range3d *r = &ranges[i];
+        Range3d *g = &greedy_ranges[greedy_box[DIM * DIM * r->start_y + DIM * r->start_z + r->start_x]];
+        if (r->type != g->type ||
+            r->start_x != g->start_x || r->start_y != g->start_y || r->start_z != g->start_z ||
+            r->end_x != g->end_x || r->end_y != g->end_y || r->end_z != g->end_z)
         {
-            printf("type %d: (%d, %d)\n", ranges[i].type, ranges[i].start, ranges[i].end);
+            printf("	range %d (%d, %d, %d) (%d, %d, %d) differs from greedy (%d, %d, %d) (%d, %d, %d)\n", i,
+                r->start_x, r->start_y, r->start_z, r->end_x, r->end_y, r->end_z,
+                g->start_x, g->start_y, g->start_z, g->end_x, g->end_y, g->end_z);
+            return (1);
         }
     }
-    else
-    {
-        printf("empty chunk!\n");
-    }
 
-    free(ranges);
+    return (0);
 }
 
-void test_2d_meshing(void)
-{
-    const int width1  = 4;
-    const int height1 = 4;
-    int blocks1[width1 * height1] = {
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 0, 0, 0,
-        0, 1, 1, 0
-    };
+//
+// benchmark
+//
 
-    int width   = width1;
-    int height  = height1;
-    int *blocks = blocks1;
+static Range3d ranges[BLOCKS_IN_CHUNK];
+static volatile long long benchmark_sink;
+static Vec3f vertices[2 * VERTICES_PER_RANGE * BLOCKS_IN_CHUNK];
 
-    int count = 0;
-    for (int i = 0; i < width * height; i++)
+int gen_vertices(Range3d *r, int nranges)
+{
+    Vec3f *vs = vertices;
+    Vec3f *ns = vertices + VERTICES_PER_RANGE * nranges;
+
+    int nvs = 0;
+    for (int i = 0; i < nranges; i++)
     {
-        if (blocks[i]) count++;
+        nvs += gen_range_vertices(&r[i], vs + nvs, ns + nvs);
     }
 
-    int ranges_count = 0;
-    Range2d *ranges = (Range2d *)calloc((width * height) / 2 + 1, sizeof(Range2d));
+    return (nvs);
+}
 
-    mesh_2d(blocks, width, height, count, ranges, &ranges_count);
+int run_variant(Chunk_set *set, Mesher_variant *variant, int repetitions)
+{
+    int failures = 0;
+    long long total_ranges = 0;
+    long long total_vs = 0;
 
-    if (ranges_count > 0)
+    for (int i = 0; i < set->count; i++)
     {
-        for (int i = 0; i < ranges_count; i++)
+        Test_chunk *c = &set->chunks[i];
+        int nranges = variant->proc(c->blocks, c->nblocks, ranges);
+
+        if (verify_ranges(c, ranges, nranges) || (variant->greedy_boxes && compare_with_greedy(c, ranges, nranges)))
         {
-            printf("(%d, %d) (%d, %d)\n", ranges[i].start_x, ranges[i].start_y, ranges[i].end_x, ranges[i].end_y);
+            printf("\t%s: chunk %d of set %s failed\n", variant->name, i, set->name);
+            failures++;
+            continue;
         }
+
+        total_ranges += nranges;
+        total_vs += gen_vertices(ranges, nranges);
     }
-    else
+
+    auto start = std::chrono::high_resolution_clock::now();
+    long long sink = 0;
+    for (int rep = 0; rep < repetitions; rep++)
     {
-        printf("empty chunk!\n");
+        for (int i = 0; i < set->count; i++)
+        {
+            Test_chunk *c = &set->chunks[i];
+            int nranges = variant->proc(c->blocks, c->nblocks, ranges);
+            sink += gen_vertices(ranges, nranges);
+        }
     }
+    auto end = std::chrono::high_resolution_clock::now();
+    benchmark_sink += sink;
+
+    double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    double runs = (double)repetitions * set->count;
 
-    free(ranges);
+    printf("%-14s %-10s %6d %12.1f %12.1f %12.0f %s\n",
+        set->name, variant->name, set->count,
+        (double)total_ranges / set->count,
+        (double)total_vs / 3.0 / set->count,
+        (runs > 0) ? ns / runs : 0.0,
+        failures ? "FAIL" : "ok");
+
+    return (failures);
 }
 
-#if 1
-void test_3d_meshing(void)
+int main(int argc, char **argv)
 {
-#define dim1 2
-    uint8_t blocks1[dim1 * dim1 * dim1] = {
-        3, 3,
-        7, 6,
-        
-        3, 3,
-        7, 6
-    };
+    int repetitions = (argc > 1) ? atoi(argv[1]) : 10;
 
-    int dim = dim1;
-    uint8_t *blocks = blocks1;
+    Chunk_set sets[] =
+    {
+        { "terrain",      0, 0 },
+        { "checkerboard", 0, 0 },
+        { "random",       0, 0 },
+        { "edge_cases",   0, 0 },
+    };
+    int num_of_sets = sizeof(sets) / sizeof(sets[0]);
 
-    int count = 0;
-    for (int i = 0; i < (dim * dim * dim); i++)
+    for (int i = 0; i < num_of_sets; i++)
     {
-        if (blocks[i]) count++;
+        sets[i].chunks = (Test_chunk *)calloc(MAX_CHUNKS_IN_SET, sizeof(Test_chunk));
     }
 
-    int ranges_count = 0;
-    Range3d *ranges = (Range3d *)calloc(dim * dim * dim, sizeof(Range3d));
+    make_terrain_set(&sets[0]);
+    make_checkerboard_set(&sets[1]);
+    make_random_set(&sets[2]);
+    make_edge_case_set(&sets[3]);
 
-    mesh_3d(blocks, dim, count, ranges, &ranges_count);
+    printf("%-14s %-10s %6s %12s %12s %12s %s\n", "set", "variant", "chunks", "ranges/chunk", "tris/chunk", "ns/chunk", "status");
 
-    if (ranges_count > 0)
+    int failures = 0;
+    for (int s = 0; s < num_of_sets; s++)
     {
-        for (int i = 0; i < ranges_count; i++)
+        for (int v = 0; v < (int)(sizeof(variants) / sizeof(variants[0])); v++)
         {
-            printf("type %d:\n\t(%d, %d, %d)\n\t(%d, %d, %d)\n",
-                ranges[i].type,
-                ranges[i].start_x, ranges[i].start_y, ranges[i].start_z,
-                ranges[i].end_x, ranges[i].end_y, ranges[i].end_z);
+            failures += run_variant(&sets[s], &variants[v], repetitions);
         }
     }
-    else
+
+    for (int i = 0; i < num_of_sets; i++)
     {
-        printf("empty chunk!\n");
+        free(sets[i].chunks);
     }
 
-    free(ranges);
-}
-#endif
-
-int main(void)
-{
-    //test_1d_meshing();
-    //test_2d_meshing();
-    test_3d_meshing();
-    
-    /*uint8_t blocks[] = {
-        1, 2, 3, 4, 5, 6, 7, 8
-    };
-
-    int n = 0;
-    Range3d ranges[8 / 2 + 1];
-    mesh_3d(blocks, 2, 8, ranges, &n);
-
-    for (int i = 0; i < n; i++)
-        printf("type %d:\n\t(%d, %d, %d)\n\t(%d, %d, %d)\n",
-            ranges[i].type, 
-            ranges[i].start_x, ranges[i].start_y, ranges[i].start_z, 
-            ranges[i].end_x, ranges[i].end_y, ranges[i].end_z);*/
+    if (failures)
+    {
+        printf("%d chunks failed verification\n", failures);
+        return (1);
+    }
 
     return (0);
 }
@@ -0,0 +1,7 @@
+@echo off
+
+pushd ..\build
+
+cl /nologo /W4 /wd4201 /Zi /O2 /MD /EHsc ..\poolbench\main.cpp /Fe:poolbench.exe
+
+popd
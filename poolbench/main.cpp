@@ -0,0 +1,253 @@
+// Chunk pool benchmark.
+//
+// Allocates and frees chunk sized blocks from several threads with new/delete, a pool guarded
+// by a mutex and the game's PoolAllocator, then runs of RUN_BLOCKS blocks (a column of chunks)
+// with new[]/delete[] and PoolAllocator::malloc(size). Every block is stamped with its owner
+// while it is allocated, so a block handed out twice is reported, and the time per block
+// allocated and freed is printed.
+//
+// usage: poolbench [rounds] [max threads]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+// NOTE: the benchmark uses the same allocator as the game
+#include "../TRITPO_Minecraft/PoolAllocator.hpp"
+
+#define BLOCK_SIZE 4352 // NOTE: about sizeof(Chunk)
+#define BLOCKS_PER_ROUND 256
+#define PAGE_BLOCKS 1024
+#define MAX_THREADS 16
+#define RUN_BLOCKS 8 // NOTE: 2 * GENERATION_Y_RADIUS, the chunks of one column
+
+struct Block
+{
+    uint32_t owner;
+    uint32_t round;
+    uint8_t payload[BLOCK_SIZE - 8];
+};
+
+struct Allocator_variant
+{
+    const char *name;
+    void *(*create)(int nthreads);
+    void (*destroy)(void *allocator);
+    int run_blocks; // NOTE: blocks taken by every alloc
+    Block *(*alloc)(void *allocator);
+    void (*release)(void *allocator, Block *b);
+};
+
+// NOTE: new/delete
+
+static void *create_heap(int) { return 0; }
+static void destroy_heap(void *) {}
+static Block *alloc_heap(void *) { return new Block; }
+static void release_heap(void *, Block *b) { delete b; }
+
+// NOTE: the single threaded free list the game used before, behind a mutex
+
+struct Mutex_pool
+{
+    std::mutex mutex;
+    Block *blocks;
+    Block *first_free;
+};
+
+static void *create_mutex_pool(int nthreads)
+{
+    int count = nthreads * BLOCKS_PER_ROUND;
+    Mutex_pool *pool = new Mutex_pool;
+    pool->blocks = (Block *)malloc(sizeof(Block) * count);
+    pool->first_free = 0;
+    for (int i = count - 1; i >= 0; i--)
+    {
+        *(Block **)&pool->blocks[i] = pool->first_free;
+        pool->first_free = &pool->blocks[i];
+    }
+    return pool;
+}
+
+static void destroy_mutex_pool(void *allocator)
+{
+    Mutex_pool *pool = (Mutex_pool *)allocator;
+    free(pool->blocks);
+    delete pool;
+}
+
+static Block *alloc_mutex_pool(void *allocator)
+{
+    Mutex_pool *pool = (Mutex_pool *)allocator;
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    Block *b = pool->first_free;
+    if (b)
+        pool->first_free = *(Block **)b;
+    return b;
+}
+
+static void release_mutex_pool(void *allocator, Block *b)
+{
+    Mutex_pool *pool = (Mutex_pool *)allocator;
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    *(Block **)b = pool->first_free;
+    pool->first_free = b;
+}
+
+// NOTE: PoolAllocator, starts without pages so that growing is part of the first round
+
+static void *create_pool(int) { return new PoolAllocator<Block>(PAGE_BLOCKS, 64); }
+static void destroy_pool(void *allocator) { delete (PoolAllocator<Block> *)allocator; }
+static Block *alloc_pool(void *allocator) { return ((PoolAllocator<Block> *)allocator)->malloc(); }
+static void release_pool(void *allocator, Block *b) { ((PoolAllocator<Block> *)allocator)->free(b); }
+
+// NOTE: runs
+
+static Block *alloc_heap_run(void *) { return new Block[RUN_BLOCKS]; }
+static void release_heap_run(void *, Block *b) { delete[] b; }
+static Block *alloc_pool_run(void *allocator) { return ((PoolAllocator<Block> *)allocator)->malloc(RUN_BLOCKS); }
+static void release_pool_run(void *allocator, Block *b) { ((PoolAllocator<Block> *)allocator)->free(b, RUN_BLOCKS); }
+
+static Allocator_variant variants[] =
+{
+    { "new/delete", create_heap, destroy_heap, 1, alloc_heap, release_heap },
+    { "mutex pool", create_mutex_pool, destroy_mutex_pool, 1, alloc_mutex_pool, release_mutex_pool },
+    { "PoolAllocator", create_pool, destroy_pool, 1, alloc_pool, release_pool },
+    { "new[] runs", create_heap, destroy_heap, RUN_BLOCKS, alloc_heap_run, release_heap_run },
+    { "Pool runs", create_pool, destroy_pool, RUN_BLOCKS, alloc_pool_run, release_pool_run },
+};
+
+struct Thread_result
+{
+    int errors;
+};
+
+// NOTE: every round allocates BLOCKS_PER_ROUND blocks and frees them in a shuffled order
+static void run_thread(Allocator_variant *variant, void *allocator, uint32_t id, int rounds, std::atomic<int> *start, Thread_result *result)
+{
+    Block *blocks[BLOCKS_PER_ROUND];
+    int count = BLOCKS_PER_ROUND / variant->run_blocks;
+    uint32_t rng = id * 2654435761u + 1;
+    result->errors = 0;
+
+    while (!start->load())
+    {
+    }
+
+    for (int round = 0; round < rounds; round++)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            Block *b = variant->alloc(allocator);
+            blocks[i] = b;
+            if (!b)
+            {
+                result->errors++;
+                continue;
+            }
+            for (int j = 0; j < variant->run_blocks; j++)
+            {
+                b[j].owner = id;
+                b[j].round = round;
+            }
+        }
+
+        for (int i = count - 1; i > 0; i--)
+        {
+            rng = rng * 1664525u + 1013904223u;
+            int j = rng % (i + 1);
+            Block *tmp = blocks[i];
+            blocks[i] = blocks[j];
+            blocks[j] = tmp;
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            Block *b = blocks[i];
+            if (!b)
+                continue;
+            for (int j = 0; j < variant->run_blocks; j++)
+            {
+                if (b[j].owner != id || b[j].round != (uint32_t)round)
+                    result->errors++;
+            }
+            variant->release(allocator, b);
+        }
+    }
+}
+
+static int run_variant(Allocator_variant *variant, int nthreads, int rounds)
+{
+    void *allocator = variant->create(nthreads);
+
+    std::thread threads[MAX_THREADS];
+    Thread_result results[MAX_THREADS];
+    std::atomic<int> start(0);
+
+    for (int i = 0; i < nthreads; i++)
+    {
+        threads[i] = std::thread(run_thread, variant, allocator, (uint32_t)i + 1, rounds, &start, &results[i]);
+    }
+
+    auto begin = std::chrono::high_resolution_clock::now();
+    start.store(1);
+    for (int i = 0; i < nthreads; i++)
+    {
+        threads[i].join();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    int errors = 0;
+    for (int i = 0; i < nthreads; i++)
+    {
+        errors += results[i].errors;
+    }
+
+    double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+    double ops = (double)nthreads * rounds * BLOCKS_PER_ROUND;
+
+    printf("%-14s %7d %12.1f %10.1f %s\n", variant->name, nthreads, ns / ops, ops / ns * 1000.0, errors ? "FAIL" : "ok");
+
+    if (variant->create == create_pool)
+    {
+        Pool_stats stats = ((PoolAllocator<Block> *)allocator)->stats();
+        printf("%-14s pages %d, run pages %d, high water %d, cas retries %lld\n", "", stats.pages, stats.run_pages, stats.high_water, (long long)stats.cas_retries);
+    }
+
+    variant->destroy(allocator);
+    return (errors);
+}
+
+int main(int argc, char **argv)
+{
+    int rounds = (argc > 1) ? atoi(argv[1]) : 2000;
+
+    int max_threads = (argc > 2) ? atoi(argv[2]) : (int)std::thread::hardware_concurrency();
+    if (max_threads < 1)
+        max_threads = 1;
+    if (max_threads > MAX_THREADS)
+        max_threads = MAX_THREADS;
+
+    printf("%-14s %7s %12s %10s %s\n", "allocator", "threads", "ns/block", "Mblocks/s", "status");
+
+    int failures = 0;
+    for (int nthreads = 1; nthreads <= max_threads; nthreads *= 2)
+    {
+        for (int v = 0; v < (int)(sizeof(variants) / sizeof(variants[0])); v++)
+        {
+            failures += run_variant(&variants[v], nthreads, rounds);
+        }
+    }
+
+    if (failures)
+    {
+        printf("%d blocks were handed out twice or not at all\n", failures);
+        return (1);
+    }
+
+    return (0);
+}